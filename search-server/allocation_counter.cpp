@@ -0,0 +1,50 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+#ifdef SEARCH_SERVER_COUNT_ALLOCATIONS
+
+namespace {
+thread_local size_t allocation_count = 0;
+}
+
+size_t GetThreadAllocationCount() {
+    return allocation_count;
+}
+
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+#else
+
+size_t GetThreadAllocationCount() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+// Счётчик выделений памяти текущего потока для тестов. Глобальный operator new заменяется,
+// только если тестовая сборка определяет SEARCH_SERVER_COUNT_ALLOCATIONS; в остальных сборках
+// счётчик не ведётся и приложение выделяет память стандартными операторами. Тест выделений
+// проверяет ALLOCATION_COUNTING_ENABLED и без счётчика падает, а не проходит молча
+#ifdef SEARCH_SERVER_COUNT_ALLOCATIONS
+constexpr bool ALLOCATION_COUNTING_ENABLED = true;
+#else
+constexpr bool ALLOCATION_COUNTING_ENABLED = false;
+#endif
+
+// Число вызовов operator new в текущем потоке; без счётчика всегда 0
+size_t GetThreadAllocationCount();
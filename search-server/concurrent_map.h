@@ -1,54 +1,212 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cstdint>
+#include <execution>
 #include <future>
-#include <map>
+#include <mutex>
 #include <numeric>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 
 using namespace std::string_literals;
 
-template <typename Key, typename Value>
+// Спин-блокировка для коротких критических секций (например, прибавления к значению)
+class SpinLock {
+public:
+    void lock() {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+// Каждый бакет — отдельная хеш-таблица с открытой адресацией под своей блокировкой.
+// Бакеты выровнены по кеш-линии, чтобы блокировки соседних бакетов не делили одну линию.
+// Lock задаёт вид блокировки бакета: std::mutex или SpinLock.
+template <typename Key, typename Value, typename Lock = std::mutex>
 class ConcurrentMap {
 private:
-    struct Bucket {
-        std::mutex mutex;
-        std::map<Key, Value> map;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot {
+        Key key;
+        Value value;
+        bool used = false;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Bucket {
+        mutable Lock lock;
+        std::vector<Slot> slots;
+        size_t size = 0;
     };
 
 public:
     static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
 
     struct Access {
-        std::lock_guard<std::mutex> guard;
+        std::lock_guard<Lock> guard;
         Value& ref_to_value;
 
-        Access(const Key& key, Bucket& bucket)
-            : guard(bucket.mutex)
-            , ref_to_value(bucket.map[key]) {
+        Access(const Key& key, size_t hash, Bucket& bucket)
+            : guard(bucket.lock)
+            , ref_to_value(FindOrInsert(bucket, key, hash).value) {
         }
     };
 
+    ConcurrentMap()
+        : ConcurrentMap(std::max(1u, std::thread::hardware_concurrency()) * 4) {
+    }
+
     explicit ConcurrentMap(size_t bucket_count)
-        : buckets_(bucket_count) {
+        : buckets_(std::max<size_t>(bucket_count, 1)) {
     }
 
     Access operator[](const Key& key) {
-        auto& bucket = buckets_[static_cast<uint64_t>(key) % buckets_.size()];
-        return { key, bucket };
+        const size_t hash = Hash(key);
+        return { key, hash, GetBucket(hash) };
+    }
+
+    // Прибавление к арифметическому значению под блокировкой бакета без создания Access.
+    // Атомарные значения без блокировки здесь не используются: рост бакета переносит слоты,
+    // и поиск ключа без блокировки читал бы перемещаемую таблицу
+    template <typename T = Value>
+    std::enable_if_t<std::is_arithmetic_v<T>> Add(const Key& key, T delta) {
+        const size_t hash = Hash(key);
+        Bucket& bucket = GetBucket(hash);
+        std::lock_guard guard(bucket.lock);
+        FindOrInsert(bucket, key, hash).value += delta;
     }
 
-    std::map<Key, Value> BuildOrdinaryMap() {
-        std::map<Key, Value> result;
-        for (auto& [mutex, map] : buckets_) {
-            std::lock_guard g(mutex);
-            result.insert(map.begin(), map.end());
+    bool Erase(const Key& key) {
+        const size_t hash = Hash(key);
+        Bucket& bucket = GetBucket(hash);
+        std::lock_guard guard(bucket.lock);
+        if (bucket.size == 0) {
+            return false;
+        }
+        const size_t mask = bucket.slots.size() - 1;
+        size_t slot = SlotIndex(hash, mask);
+        while (bucket.slots[slot].used && bucket.slots[slot].key != key) {
+            slot = (slot + 1) & mask;
+        }
+        if (!bucket.slots[slot].used) {
+            return false;
+        }
+        // Удаление со сдвигом назад: цепочки пробирования остаются без «дыр»
+        for (size_t next = (slot + 1) & mask; bucket.slots[next].used; next = (next + 1) & mask) {
+            const size_t home = SlotIndex(Hash(bucket.slots[next].key), mask);
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                bucket.slots[slot] = std::move(bucket.slots[next]);
+                slot = next;
+            }
+        }
+        bucket.slots[slot] = Slot{};
+        --bucket.size;
+        return true;
+    }
+
+    size_t size() const {
+        size_t result = 0;
+        for (const Bucket& bucket : buckets_) {
+            std::lock_guard guard(bucket.lock);
+            result += bucket.size;
         }
         return result;
     }
 
+    // Обход без копирования: бакеты обрабатываются параллельно, каждый под своей блокировкой
+    template <typename ExecutionPolicy, typename Func>
+    void ForEach(const ExecutionPolicy& policy, Func func) {
+        std::for_each(policy, buckets_.begin(), buckets_.end(), [&func](Bucket& bucket) {
+            std::lock_guard guard(bucket.lock);
+            for (Slot& slot : bucket.slots) {
+                if (slot.used) {
+                    func(slot.key, slot.value);
+                }
+            }
+        });
+    }
+
+    // Как ForEach, но передаёт значения во владение func и очищает карту
+    template <typename ExecutionPolicy, typename Func>
+    void Drain(const ExecutionPolicy& policy, Func func) {
+        std::for_each(policy, buckets_.begin(), buckets_.end(), [&func](Bucket& bucket) {
+            std::lock_guard guard(bucket.lock);
+            for (Slot& slot : bucket.slots) {
+                if (slot.used) {
+                    func(slot.key, std::move(slot.value));
+                }
+            }
+            bucket.slots.clear();
+            bucket.size = 0;
+        });
+    }
+
 private:
     std::vector<Bucket> buckets_;
+
+    static size_t Hash(const Key& key) {
+        uint64_t x = static_cast<uint64_t>(key);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+
+    static size_t SlotIndex(size_t hash, size_t mask) {
+        return (hash >> 16) & mask;
+    }
+
+    Bucket& GetBucket(size_t hash) {
+        return buckets_[hash % buckets_.size()];
+    }
+
+    static Slot& FindOrInsert(Bucket& bucket, const Key& key, size_t hash) {
+        if ((bucket.size + 1) * 4 > bucket.slots.size() * 3) {
+            Grow(bucket);
+        }
+        const size_t mask = bucket.slots.size() - 1;
+        size_t slot = SlotIndex(hash, mask);
+        while (bucket.slots[slot].used) {
+            if (bucket.slots[slot].key == key) {
+                return bucket.slots[slot];
+            }
+            slot = (slot + 1) & mask;
+        }
+        bucket.slots[slot].key = key;
+        bucket.slots[slot].value = Value();
+        bucket.slots[slot].used = true;
+        ++bucket.size;
+        return bucket.slots[slot];
+    }
+
+    static void Grow(Bucket& bucket) {
+        std::vector<Slot> old_slots(std::max<size_t>(bucket.slots.size() * 2, 8));
+        old_slots.swap(bucket.slots);
+        const size_t mask = bucket.slots.size() - 1;
+        for (Slot& old_slot : old_slots) {
+            if (!old_slot.used) {
+                continue;
+            }
+            size_t slot = SlotIndex(Hash(old_slot.key), mask);
+            while (bucket.slots[slot].used) {
+                slot = (slot + 1) & mask;
+            }
+            bucket.slots[slot] = std::move(old_slot);
+        }
+    }
 };
@@ -0,0 +1,83 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(std::string_view stop_words_text)
+    : servers_{ std::make_unique<SearchServer>(stop_words_text), std::make_unique<SearchServer>(stop_words_text) }
+{
+}
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text)
+    : ConcurrentSearchServer(std::string_view(stop_words_text))
+{
+}
+
+// Читатель сначала увеличивает счётчик копии и лишь затем проверяет, что она всё ещё опубликована.
+// Если писатель успел переключиться, читатель уходит и повторяет попытку с новой копией: так писатель,
+// увидевший нулевой счётчик после переключения, не может пропустить читателя старой копии
+ConcurrentSearchServer::ReadGuard::ReadGuard(const ConcurrentSearchServer& server)
+    : server_(server)
+{
+    while (true) {
+        index_ = server_.active_.load(std::memory_order_seq_cst);
+        server_.readers_[index_].value.fetch_add(1, std::memory_order_seq_cst);
+        if (server_.active_.load(std::memory_order_seq_cst) == index_) {
+            break;
+        }
+        server_.readers_[index_].value.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+ConcurrentSearchServer::ReadGuard::~ReadGuard() {
+    server_.readers_[index_].value.fetch_sub(1, std::memory_order_release);
+}
+
+const SearchServer& ConcurrentSearchServer::ReadGuard::GetServer() const {
+    return *server_.servers_[index_];
+}
+
+void ConcurrentSearchServer::WaitForReaders(int index) const {
+    while (readers_[index].value.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    Write([&](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void ConcurrentSearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    Write([&documents](SearchServer& server) {
+        server.AddDocuments(documents);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    Write([&document_ids](SearchServer& server) {
+        server.RemoveDocuments(document_ids);
+    });
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
+    return Read([&](const SearchServer& server) {
+        return server.FindTopDocuments(raw_query, status, max_result_count);
+    });
+}
+
+size_t ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& server) {
+        return server.GetDocumentCount();
+    });
+}
+
+uint64_t ConcurrentSearchServer::GetGeneration() const {
+    return generation_.load(std::memory_order_acquire);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "search_server.h"
+
+// Поисковый сервер для одновременных чтений и записей (схема left-right, вариант RCU с двумя поколениями).
+// Индекс хранится в двух копиях: читатели без блокировок работают с опубликованной копией, писатель
+// применяет изменение к другой, публикует её, дожидается ухода читателей старого поколения
+// (период ожидания по счётчику читателей) и повторяет изменение на освободившейся копии.
+// Запросы не ждут записей; запись ждёт только завершения уже начатых запросов.
+// Память индекса удваивается, каждое изменение выполняется дважды.
+class ConcurrentSearchServer {
+public:
+    explicit ConcurrentSearchServer(std::string_view stop_words_text);
+    explicit ConcurrentSearchServer(const std::string& stop_words_text);
+
+    // Выполняет func(const SearchServer&) на опубликованном поколении. Ссылки и string_view из результата
+    // действительны только внутри func: после выхода поколение может меняться писателем
+    template <typename Func>
+    auto Read(Func func) const;
+
+    // Применяет func(SearchServer&) к обеим копиям по очереди; func должна менять индекс детерминированно.
+    // Инвариант: вне Write обе копии совпадают. Поэтому func бросает исключение, только не изменив копию
+    // (методы SearchServer проверяют аргументы до изменения индекса): тогда ничего не публикуется.
+    // Повтор на второй копии не должен бросать: если он всё же бросил, копии разошлись, а восстановить
+    // копию нечем (SearchServer не копируется), и процесс завершается через std::terminate.
+    // Записи выполняются по одной
+    template <typename Func>
+    void Write(Func func);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void AddDocuments(const std::vector<NewDocument>& documents);
+    void RemoveDocument(int document_id);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    size_t GetDocumentCount() const;
+    // Число опубликованных изменений
+    uint64_t GetGeneration() const;
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) ReaderCount {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    // Счётчик читателей копии на время запроса
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ConcurrentSearchServer& server);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const SearchServer& GetServer() const;
+
+    private:
+        const ConcurrentSearchServer& server_;
+        int index_;
+    };
+
+    std::array<std::unique_ptr<SearchServer>, 2> servers_;
+    alignas(CACHE_LINE_SIZE) std::atomic<int> active_ = 0;
+    std::atomic<uint64_t> generation_ = 0;
+    mutable std::array<ReaderCount, 2> readers_;
+    std::mutex write_mutex_;
+
+    void WaitForReaders(int index) const;
+};
+
+template <typename Func>
+auto ConcurrentSearchServer::Read(Func func) const {
+    const ReadGuard guard(*this);
+    return func(guard.GetServer());
+}
+
+template <typename Func>
+void ConcurrentSearchServer::Write(Func func) {
+    std::lock_guard guard(write_mutex_);
+    const int active = active_.load(std::memory_order_relaxed);
+    const int inactive = 1 - active;
+    func(*servers_[inactive]);
+    active_.store(inactive, std::memory_order_seq_cst);
+    generation_.fetch_add(1, std::memory_order_release);
+    WaitForReaders(active);
+    try {
+        func(*servers_[active]);
+    }
+    catch (...) {
+        std::terminate();
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// Наборы SIMD-инструкций, для которых собираются ядра, и проверка AVX2 на текущем процессоре.
+// SSE2 есть на любом x86-64, поэтому его достаточно проверить при компиляции; AVX2-ядра
+// компилируются с атрибутом target("avx2") и выбираются во время выполнения
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CPU_FEATURES_SSE2 1
+#endif
+#if defined(CPU_FEATURES_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CPU_FEATURES_AVX2 1
+#endif
+
+// Поддерживает ли процессор AVX2. Вызывается и из статической инициализации, до конструкторов libgcc
+inline bool CpuHasAvx2() {
+#ifdef CPU_FEATURES_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
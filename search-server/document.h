@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
-#include "search_server.h"
+#include <string_view>
+#include <vector>
 
 enum class DocumentStatus {
     ACTUAL,
@@ -16,6 +17,14 @@ struct Document {
     double relevance = 0.0;
     int rating = 0;
 };
+// Документ для пакетного добавления в поисковый сервер
+struct NewDocument {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 std::ostream& operator<<(std::ostream& out, const Document& document);
 
 void PrintDocument(const Document& document);
@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Битовое множество внутренних номеров документов
+class DocumentBitset {
+public:
+    void Resize(size_t size) {
+        words_.resize((size + 63) / 64, 0);
+        size_ = size;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool Test(int document_number) const {
+        return (words_[document_number >> 6] >> (document_number & 63)) & 1;
+    }
+
+    void Set(int document_number) {
+        words_[document_number >> 6] |= uint64_t{ 1 } << (document_number & 63);
+    }
+
+    void Reset(int document_number) {
+        words_[document_number >> 6] &= ~(uint64_t{ 1 } << (document_number & 63));
+    }
+
+    // Первый установленный номер не меньше document_number или size(), если таких нет
+    int FindNext(int document_number) const {
+        size_t word = static_cast<size_t>(document_number) >> 6;
+        if (word >= words_.size()) {
+            return static_cast<int>(size_);
+        }
+        uint64_t bits = words_[word] & (~uint64_t{ 0 } << (document_number & 63));
+        while (bits == 0) {
+            if (++word == words_.size()) {
+                return static_cast<int>(size_);
+            }
+            bits = words_[word];
+        }
+#if defined(__GNUC__)
+        return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+#else
+        int bit = 0;
+        while (((bits >> bit) & 1) == 0) {
+            ++bit;
+        }
+        return static_cast<int>(word * 64 + bit);
+#endif
+    }
+
+    void Clear() {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
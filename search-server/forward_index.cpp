@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "forward_index.h"
+
+using namespace std::string_literals;
+
+void SortForwardEntries(ForwardEntry* first, ForwardEntry* last) {
+    std::sort(first, last, [](const ForwardEntry& lhs, const ForwardEntry& rhs) {
+        return lhs.term_id < rhs.term_id;
+    });
+}
+
+WordFrequencies::WordFrequencies(const ForwardEntry* first, const ForwardEntry* last, const TermDictionary& dictionary)
+    : first_(first)
+    , last_(last)
+    , dictionary_(&dictionary) {
+}
+
+WordFrequencies::Iterator WordFrequencies::begin() const {
+    return Iterator(first_, dictionary_);
+}
+
+WordFrequencies::Iterator WordFrequencies::end() const {
+    return Iterator(last_, dictionary_);
+}
+
+size_t WordFrequencies::size() const {
+    return static_cast<size_t>(last_ - first_);
+}
+
+bool WordFrequencies::empty() const {
+    return first_ == last_;
+}
+
+size_t WordFrequencies::count(std::string_view word) const {
+    return !empty() && Contains(dictionary_->Find(word)) ? 1 : 0;
+}
+
+double WordFrequencies::at(std::string_view word) const {
+    const ForwardEntry* entry = empty() ? nullptr : Find(dictionary_->Find(word));
+    if (entry == nullptr) {
+        throw std::out_of_range("Word is not found in the document"s);
+    }
+    return entry->term_freq;
+}
+
+const ForwardEntry* WordFrequencies::Find(TermId term_id) const {
+    const ForwardEntry* entry = std::lower_bound(first_, last_, term_id,
+        [](const ForwardEntry& entry, TermId id) {
+            return entry.term_id < id;
+        });
+    return entry != last_ && entry->term_id == term_id ? entry : nullptr;
+}
+
+bool WordFrequencies::Contains(TermId term_id) const {
+    return Find(term_id) != nullptr;
+}
+
+const ForwardEntry* WordFrequencies::GetFirstEntry() const {
+    return first_;
+}
+
+const ForwardEntry* WordFrequencies::GetLastEntry() const {
+    return last_;
+}
+
+bool WordFrequencies::operator==(const WordFrequencies& other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+}
+
+bool WordFrequencies::operator!=(const WordFrequencies& other) const {
+    return !(*this == other);
+}
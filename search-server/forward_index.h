@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#include "term_dictionary.h"
+
+// Слово документа в прямом индексе. Слова всех документов лежат в общем массиве,
+// у каждого документа — непрерывный участок, упорядоченный по TermId
+struct ForwardEntry {
+    TermId term_id;
+    float term_freq;
+};
+
+// Упорядочивает участок документа по TermId
+void SortForwardEntries(ForwardEntry* first, ForwardEntry* last);
+
+// Частоты слов документа: лёгкое представление над его участком прямого индекса.
+// Перебор даёт пары (слово, частота) в порядке TermId; поиск слова — через словарь и двоичный поиск.
+// Представление действительно до следующего изменения сервера
+class WordFrequencies {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        // Пара строится при разыменовании, поэтому -> возвращает её копию
+        struct ArrowProxy {
+            value_type value;
+
+            const value_type* operator->() const {
+                return &value;
+            }
+        };
+
+        Iterator(const ForwardEntry* entry, const TermDictionary* dictionary)
+            : entry_(entry)
+            , dictionary_(dictionary) {
+        }
+
+        value_type operator*() const {
+            return { dictionary_->GetTerm(entry_->term_id), entry_->term_freq };
+        }
+
+        ArrowProxy operator->() const {
+            return { **this };
+        }
+
+        Iterator& operator++() {
+            ++entry_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++entry_;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return entry_ == other.entry_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return entry_ != other.entry_;
+        }
+
+    private:
+        const ForwardEntry* entry_;
+        const TermDictionary* dictionary_;
+    };
+
+    WordFrequencies() = default;
+    WordFrequencies(const ForwardEntry* first, const ForwardEntry* last, const TermDictionary& dictionary);
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    size_t count(std::string_view word) const;
+    // Бросает std::out_of_range, если слова в документе нет
+    double at(std::string_view word) const;
+
+    // Слово по TermId или nullptr
+    const ForwardEntry* Find(TermId term_id) const;
+    bool Contains(TermId term_id) const;
+
+    const ForwardEntry* GetFirstEntry() const;
+    const ForwardEntry* GetLastEntry() const;
+
+    bool operator==(const WordFrequencies& other) const;
+    bool operator!=(const WordFrequencies& other) const;
+
+private:
+    const ForwardEntry* first_ = nullptr;
+    const ForwardEntry* last_ = nullptr;
+    const TermDictionary* dictionary_ = nullptr;
+};
@@ -3,10 +3,24 @@
 #include <string>
 #include <vector>
 #include <random>
+#include <map>
+#include <thread>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <limits>
 
 #include "process_queries.h"
 #include "search_server.h"
 #include "log_duration.h"
+#include "posting_list.h"
+#include "posting_codec.h"
+#include "concurrent_map.h"
+#include "concurrent_search_server.h"
+#include "string_processing.h"
 
 using namespace std;
 
@@ -67,6 +81,533 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
 
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 
+size_t allocated_bytes = 0;
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {
+    }
+
+    T* allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        allocator<T>().deallocate(p, n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>&, const CountingAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>&, const CountingAllocator<U>&) {
+    return false;
+}
+
+// Сравнение старого индекса (вложенные std::map) с постинг-листами: память и полный обход постингов запросов
+void BenchmarkPostingLists(const vector<string>& documents, const vector<string>& queries) {
+    using DocumentFreqs = map<int, double, less<int>, CountingAllocator<pair<const int, double>>>;
+    map<string_view, DocumentFreqs> nested_index;
+    map<string_view, PostingList> posting_index;
+
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const auto words = SplitIntoWords(string_view(documents[i]));
+        const double inv_word_count = 1.0 / words.size();
+        map<string_view, double> word_freqs;
+        for (const string_view word : words) {
+            word_freqs[word] += inv_word_count;
+        }
+        for (const auto& [word, term_freq] : word_freqs) {
+            nested_index[word][static_cast<int>(i)] = term_freq;
+            posting_index[word].Add(static_cast<int>(i), term_freq);
+        }
+    }
+
+    size_t posting_bytes = 0;
+    for (const auto& [word, postings] : posting_index) {
+        posting_bytes += postings.GetMemoryUsage();
+    }
+    cout << "std::map postings: "s << allocated_bytes / 1024 << " KB, PostingList: "s << posting_bytes / 1024 << " KB"s << endl;
+
+    double total_freq = 0;
+    {
+        LOG_DURATION("std::map traversal"s);
+        for (const string_view query : queries) {
+            for (const string_view word : SplitIntoWords(query)) {
+                const auto it = nested_index.find(word);
+                if (it == nested_index.end()) {
+                    continue;
+                }
+                for (const auto& [document_id, term_freq] : it->second) {
+                    total_freq += term_freq;
+                }
+            }
+        }
+    }
+    const PostingDecodeKernel default_kernel = GetPostingDecodeKernel();
+    for (const auto& [kernel, name] : { pair{ PostingDecodeKernel::SCALAR, "scalar"s },
+        pair{ PostingDecodeKernel::SSE2, "SSE2"s }, pair{ PostingDecodeKernel::AVX2, "AVX2"s } }) {
+        if (!IsPostingDecodeKernelSupported(kernel)) {
+            continue;
+        }
+        SetPostingDecodeKernel(kernel);
+        LOG_DURATION("PostingList traversal, "s + name);
+        for (const string_view query : queries) {
+            for (const string_view word : SplitIntoWords(query)) {
+                const auto it = posting_index.find(word);
+                if (it == posting_index.end()) {
+                    continue;
+                }
+                it->second.ForEach([&total_freq](int, double term_freq) {
+                    total_freq += term_freq;
+                });
+            }
+        }
+    }
+    SetPostingDecodeKernel(default_kernel);
+    cout << total_freq << endl;
+
+    // Длинные списки: распаковка блоков против чтения несжатого массива
+    vector<int> long_documents(1'000'000);
+    vector<uint32_t> packed;
+    vector<uint32_t> bit_widths;
+    for (size_t i = 0; i < long_documents.size(); ++i) {
+        long_documents[i] = static_cast<int>(i * 3 + i % 2);
+    }
+    for (size_t first = 0; first < long_documents.size(); first += POSTING_BLOCK_SIZE) {
+        bit_widths.push_back(PackPostingBlock(long_documents.data() + first, packed));
+    }
+    cout << "1M postings: raw "s << long_documents.size() * sizeof(int) / 1024 << " KB, packed "s
+        << packed.size() * sizeof(uint32_t) / 1024 << " KB"s << endl;
+    for (const auto& [kernel, name] : { pair{ PostingDecodeKernel::SCALAR, "scalar"s },
+        pair{ PostingDecodeKernel::SSE2, "SSE2"s }, pair{ PostingDecodeKernel::AVX2, "AVX2"s } }) {
+        if (!IsPostingDecodeKernelSupported(kernel)) {
+            continue;
+        }
+        int documents[POSTING_BLOCK_SIZE];
+        int64_t checksum = 0;
+        {
+            LOG_DURATION("decode 100M postings, "s + name);
+            for (int repeat = 0; repeat < 100; ++repeat) {
+                const uint32_t* block = packed.data();
+                for (size_t i = 0; i < bit_widths.size(); ++i) {
+                    DecodePostingBlock(block, bit_widths[i], long_documents[i * POSTING_BLOCK_SIZE], documents, kernel);
+                    block += bit_widths[i] * 4;
+                    checksum += documents[POSTING_BLOCK_SIZE - 1];
+                }
+            }
+        }
+        cout << checksum << endl;
+    }
+}
+
+// Пакетная обработка запросов против поиска по каждому запросу отдельно
+void BenchmarkProcessQueries(const SearchServer& search_server, const vector<string>& queries) {
+    vector<vector<Document>> single_results(queries.size());
+    {
+        LOG_DURATION("FindTopDocuments per query"s);
+        transform(execution::par, queries.begin(), queries.end(), single_results.begin(),
+            [&search_server](const string& query) { return search_server.FindTopDocuments(query); });
+    }
+    vector<vector<Document>> batch_results;
+    {
+        LOG_DURATION("ProcessQueries"s);
+        batch_results = ProcessQueries(search_server, queries);
+    }
+    size_t result_count = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        result_count += batch_results[i].size();
+        if (batch_results[i].size() != single_results[i].size()) {
+            cout << "ProcessQueries mismatch for query "s << i << endl;
+        }
+    }
+    cout << result_count << endl;
+    size_t joined_count = 0;
+    {
+        LOG_DURATION("ProcessQueriesJoined"s);
+        for (const Document& document : ProcessQueriesJoined(search_server, queries)) {
+            joined_count += document.id >= 0;
+        }
+    }
+    if (joined_count != result_count) {
+        cout << "ProcessQueriesJoined mismatch"s << endl;
+    }
+}
+
+// Индексация по одному документу против пакетного добавления
+void BenchmarkAddDocuments(const string& stop_words, const vector<string>& texts) {
+    vector<NewDocument> documents;
+    documents.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    {
+        SearchServer search_server(stop_words);
+        LOG_DURATION("AddDocument"s);
+        for (const NewDocument& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+    {
+        SearchServer search_server(stop_words);
+        LOG_DURATION("AddDocuments seq"s);
+        search_server.AddDocuments(execution::seq, documents);
+    }
+    {
+        SearchServer search_server(stop_words);
+        LOG_DURATION("AddDocuments par"s);
+        search_server.AddDocuments(execution::par, documents);
+    }
+}
+
+// Истечение срока: удаление половины документов по одному против пакетного удаления
+void BenchmarkRemoveDocuments(const string& stop_words, const vector<string>& texts) {
+    vector<NewDocument> documents;
+    documents.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    vector<int> expired;
+    for (size_t i = 0; i < texts.size(); i += 2) {
+        expired.push_back(static_cast<int>(i));
+    }
+    {
+        SearchServer search_server(stop_words);
+        search_server.AddDocuments(execution::par, documents);
+        LOG_DURATION("RemoveDocument x"s + to_string(expired.size()));
+        for (const int document_id : expired) {
+            search_server.RemoveDocument(document_id);
+        }
+        search_server.CompactPostings();
+    }
+    {
+        SearchServer search_server(stop_words);
+        search_server.AddDocuments(execution::par, documents);
+        LOG_DURATION("RemoveDocuments par"s);
+        search_server.RemoveDocuments(execution::par, expired);
+        search_server.CompactPostings(execution::par);
+    }
+}
+
+// Задержка запросов во время непрерывной индексации: глобальная блокировка чтения-записи против двух поколений
+template <typename Index, typename Search, typename Add>
+void MeasureLatencyDuringIngest(const string& mark, Index& index, const vector<string>& texts,
+    const vector<string>& queries, Search search, Add add) {
+    atomic<bool> done = false;
+    thread writer([&] {
+        for (size_t i = texts.size() / 2; i < texts.size(); ++i) {
+            add(index, static_cast<int>(i), texts[i]);
+        }
+        done = true;
+    });
+    vector<double> latencies;
+    size_t result_count = 0;
+    for (size_t i = 0; !done || latencies.empty(); ++i) {
+        const auto start = chrono::steady_clock::now();
+        result_count += search(index, queries[i % queries.size()]).size();
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+    writer.join();
+    sort(latencies.begin(), latencies.end());
+    cout << mark << ": queries "s << latencies.size() << ", p50 "s << static_cast<int>(latencies[latencies.size() / 2])
+        << " us, p99 "s << static_cast<int>(latencies[latencies.size() * 99 / 100]) << " us, results "s << result_count << endl;
+}
+
+void BenchmarkConcurrentIngest(const string& stop_words, const vector<string>& texts, const vector<string>& queries) {
+    vector<NewDocument> initial;
+    for (size_t i = 0; i < texts.size() / 2; ++i) {
+        initial.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+
+    struct LockedServer {
+        SearchServer server;
+        shared_mutex mutex;
+    } locked{ SearchServer(stop_words), {} };
+    locked.server.AddDocuments(execution::par, initial);
+    MeasureLatencyDuringIngest("shared_mutex"s, locked, texts, queries,
+        [](LockedServer& index, const string& query) {
+            shared_lock guard(index.mutex);
+            return index.server.FindTopDocuments(query);
+        },
+        [](LockedServer& index, int document_id, const string& text) {
+            lock_guard guard(index.mutex);
+            index.server.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 1, 2, 3 });
+        });
+
+    ConcurrentSearchServer concurrent(stop_words);
+    concurrent.AddDocuments(initial);
+    MeasureLatencyDuringIngest("ConcurrentSearchServer"s, concurrent, texts, queries,
+        [](ConcurrentSearchServer& index, const string& query) {
+            return index.FindTopDocuments(query);
+        },
+        [](ConcurrentSearchServer& index, int document_id, const string& text) {
+            index.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 1, 2, 3 });
+        });
+}
+
+// Скользящее окно документов: каждое добавление сопровождается удалением самого старого документа.
+// В одном сегменте мёртвые постинги копятся до общего сжатия; в сегментах их убирают фоновые слияния
+void BenchmarkSegmentedIngest(const string& stop_words, const vector<string>& texts) {
+    const auto measure = [&](const string& mark, size_t memory_segment_document_count) {
+        SearchServer search_server(stop_words);
+        search_server.SetSegmentPolicy(memory_segment_document_count, 4);
+        const size_t window = texts.size() / 2;
+        for (size_t i = 0; i < window; ++i) {
+            search_server.AddDocument(static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        vector<double> latencies;
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = window; i < window * 5; ++i) {
+            const auto operation_start = chrono::steady_clock::now();
+            search_server.AddDocument(static_cast<int>(i), texts[i % texts.size()], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            search_server.RemoveDocument(static_cast<int>(i - window));
+            latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - operation_start).count());
+        }
+        const auto total = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        sort(latencies.begin(), latencies.end());
+        cout << mark << ": "s << total << " ms, p99 "s << static_cast<int>(latencies[latencies.size() * 99 / 100])
+            << " us, max "s << static_cast<int>(latencies.back()) << " us, segments "s << search_server.GetSegmentCount()
+            << ", postings "s << search_server.GetMemoryUsage().postings / 1024 << " KB"s << endl;
+    };
+    measure("single segment"s, numeric_limits<size_t>::max());
+    measure("segments of 4096"s, 4096);
+}
+
+// Поиск редкого статуса: фильтр по маске статуса против произвольного предиката с тем же условием
+void BenchmarkStatusFilter(const string& stop_words, const vector<string>& texts, const vector<string>& queries) {
+    vector<NewDocument> documents;
+    documents.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const DocumentStatus status = i % 50 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        documents.push_back({ static_cast<int>(i), texts[i], status, { 1, 2, 3 } });
+    }
+    SearchServer search_server(stop_words);
+    search_server.AddDocuments(execution::par, documents);
+    const auto measure = [&](const string& mark, const auto& find) {
+        double total_relevance = 0.0;
+        {
+            LOG_DURATION(mark);
+            for (const string& query : queries) {
+                for (const Document& document : find(query)) {
+                    total_relevance += document.relevance;
+                }
+            }
+        }
+        cout << total_relevance << endl;
+    };
+    measure("status BANNED predicate"s, [&search_server](const string& query) {
+        return search_server.FindTopDocuments(query, [](int /*document_id*/, DocumentStatus status, int /*rating*/) {
+            return status == DocumentStatus::BANNED;
+            });
+        });
+    measure("status BANNED bitset"s, [&search_server](const string& query) {
+        return search_server.FindTopDocuments(query, DocumentStatus::BANNED);
+        });
+}
+
+// Листание 20 страниц по 10 документов: отдельный отбор offset + limit на каждую страницу против продолжений
+void BenchmarkPagedSearch(const SearchServer& search_server, const vector<string>& queries) {
+    const size_t page_size = 10;
+    const size_t page_count = 20;
+    size_t document_count = 0;
+    {
+        LOG_DURATION("pages by offset"s);
+        for (const string& query : queries) {
+            for (size_t page = 0; page < page_count; ++page) {
+                const auto documents = search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, (page + 1) * page_size);
+                document_count += documents.size() - min(documents.size(), page * page_size);
+            }
+        }
+    }
+    cout << document_count << endl;
+    document_count = 0;
+    {
+        LOG_DURATION("pages by cursor"s);
+        for (const string& query : queries) {
+            auto page = search_server.FindTopDocumentsPage(query, DocumentStatus::ACTUAL, 0, page_size);
+            document_count += page.documents.size();
+            for (size_t i = 1; i < page_count && !page.next.IsEnd(); ++i) {
+                page = search_server.FindNextPage(page.next, page_size);
+                document_count += page.documents.size();
+            }
+        }
+    }
+    cout << document_count << endl;
+}
+
+// Сопоставление запроса со всеми документами: MatchDocument для каждого id против одного пакетного вызова
+void BenchmarkMatchDocuments(const SearchServer& search_server, const vector<string>& queries) {
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    size_t matched_words = 0;
+    {
+        LOG_DURATION("MatchDocument for every document"s);
+        for (const string& query : queries) {
+            for (const int document_id : document_ids) {
+                matched_words += get<0>(search_server.MatchDocument(query, document_id)).size();
+            }
+        }
+    }
+    cout << matched_words << endl;
+    const auto measure = [&](const string& mark, const auto& policy) {
+        size_t matched_words = 0;
+        {
+            LOG_DURATION(mark);
+            for (const string& query : queries) {
+                for (const auto& [words, status] : search_server.MatchDocuments(policy, query, document_ids)) {
+                    matched_words += words.size();
+                }
+            }
+        }
+        cout << matched_words << endl;
+    };
+    measure("MatchDocuments seq"s, execution::seq);
+    measure("MatchDocuments par"s, execution::par);
+}
+
+// Холодный старт: загрузка снимка против повторной индексации
+void BenchmarkSnapshot(const SearchServer& search_server) {
+    const string path = "search_server_snapshot.bin"s;
+    {
+        LOG_DURATION("SaveSnapshot"s);
+        search_server.SaveSnapshot(path);
+    }
+    size_t document_count = 0;
+    {
+        LOG_DURATION("LoadSnapshot"s);
+        document_count = SearchServer::LoadSnapshot(path).GetDocumentCount();
+    }
+    cout << document_count << endl;
+    remove(path.c_str());
+}
+
+// Поток запросов с перекосом (закон Ципфа): без кеша и с кешем результатов
+void BenchmarkQueryCache(SearchServer& search_server, const vector<string>& distinct_queries, mt19937& generator) {
+    vector<double> weights(distinct_queries.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / (i + 1);
+    }
+    discrete_distribution<size_t> query_distribution(weights.begin(), weights.end());
+    vector<size_t> query_log(5'000);
+    for (size_t& query_index : query_log) {
+        query_index = query_distribution(generator);
+    }
+    for (const size_t capacity : { size_t{ 0 }, size_t{ 256 } }) {
+        search_server.SetQueryCacheCapacity(capacity);
+        size_t result_count = 0;
+        {
+            LOG_DURATION("query cache capacity: "s + to_string(capacity));
+            for (const size_t query_index : query_log) {
+                result_count += search_server.FindTopDocuments(distinct_queries[query_index]).size();
+            }
+        }
+        const auto stats = search_server.GetQueryCacheStats();
+        cout << result_count << ", cache hits: "s << stats.hits << ", misses: "s << stats.misses << endl;
+    }
+    search_server.SetQueryCacheCapacity(0);
+}
+
+// Конкурентное накопление в ConcurrentMap: число потоков, вид блокировки и число бакетов
+template <typename Lock>
+void BenchmarkConcurrentMap(const string& mark, size_t thread_count, size_t bucket_count) {
+    const int operation_count = 4'000'000;
+    const int key_count = 10'000;
+    ConcurrentMap<int, double, Lock> accumulator(bucket_count);
+    {
+        LOG_DURATION(mark + ", threads: "s + to_string(thread_count) + ", buckets: "s + to_string(bucket_count));
+        vector<thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&accumulator, i, thread_count, operation_count, key_count] {
+                mt19937 generator(static_cast<unsigned>(i));
+                uniform_int_distribution<int> key_distribution(0, key_count - 1);
+                for (size_t j = i; j < static_cast<size_t>(operation_count); j += thread_count) {
+                    accumulator.Add(key_distribution(generator), 1.0);
+                }
+            });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+    }
+    double total = 0;
+    accumulator.ForEach(execution::seq, [&total](int, double value) {
+        total += value;
+    });
+    if (total != operation_count) {
+        cout << "ConcurrentMap lost updates: "s << total << endl;
+    }
+}
+
+void BenchmarkConcurrentMaps() {
+    for (const size_t thread_count : { 1, 2, 4, 8 }) {
+        BenchmarkConcurrentMap<mutex>("std::mutex"s, thread_count, 1);
+        BenchmarkConcurrentMap<mutex>("std::mutex"s, thread_count, thread_count * 4);
+        BenchmarkConcurrentMap<SpinLock>("SpinLock"s, thread_count, thread_count * 4);
+    }
+}
+
+// Пропускная способность токенизатора: прежняя схема (find + отдельная проверка + новый вектор) против SIMD-ядер
+void BenchmarkTokenizer(const vector<string>& documents) {
+    constexpr int REPEAT_COUNT = 20;
+    size_t total_bytes = 0;
+    for (const string& document : documents) {
+        total_bytes += document.size();
+    }
+    total_bytes *= REPEAT_COUNT;
+    const auto report = [total_bytes](const string& name, chrono::steady_clock::duration duration, size_t word_count) {
+        const double seconds = chrono::duration<double>(duration).count();
+        cout << "tokenizer, "s << name << ": "s << static_cast<int>(total_bytes / seconds / (1024 * 1024))
+            << " MB/s, words: "s << word_count << endl;
+    };
+
+    size_t word_count = 0;
+    auto start = chrono::steady_clock::now();
+    for (int repeat = 0; repeat < REPEAT_COUNT; ++repeat) {
+        for (string_view text : documents) {
+            vector<string_view> words;
+            while (true) {
+                const auto space = text.find(' ');
+                words.push_back(text.substr(0, space));
+                if (space == text.npos) {
+                    break;
+                }
+                text.remove_prefix(space + 1);
+            }
+            for (const string_view word : words) {
+                word_count += none_of(word.begin(), word.end(), [](char c) {
+                    return c >= '\0' && c < ' ';
+                    });
+            }
+        }
+    }
+    report("find + IsValidWord"s, chrono::steady_clock::now() - start, word_count);
+
+    vector<string_view> words;
+    for (const auto& [kernel, name] : { pair{ TokenizerKernel::SCALAR, "scalar"s },
+        pair{ TokenizerKernel::SSE2, "SSE2"s }, pair{ TokenizerKernel::AVX2, "AVX2"s } }) {
+        if (!IsTokenizerKernelSupported(kernel)) {
+            continue;
+        }
+        word_count = 0;
+        start = chrono::steady_clock::now();
+        for (int repeat = 0; repeat < REPEAT_COUNT; ++repeat) {
+            for (const string& document : documents) {
+                if (SplitIntoWords(document, words, kernel)) {
+                    word_count += words.size();
+                }
+            }
+        }
+        report(name, chrono::steady_clock::now() - start, word_count);
+    }
+}
+
 int main() {
 //    SearchServer search_server("and with"s);
 //
@@ -115,6 +656,37 @@ int main() {
 
     const auto queries = GenerateQueries(generator, dictionary, 100, 70);
 
-    TEST(seq);
+    const auto memory_usage = search_server.GetMemoryUsage();
+    cout << "memory, KB: texts "s << memory_usage.document_texts / 1024
+        << ", terms "s << memory_usage.terms / 1024
+        << ", postings "s << memory_usage.postings / 1024
+        << ", word frequencies "s << memory_usage.word_frequencies / 1024
+        << ", documents "s << memory_usage.documents / 1024
+        << ", total "s << memory_usage.GetTotal() / 1024 << endl;
+
+    // Последовательный поиск по умолчанию идёт слово за словом
+    Test("seq, term-at-a-time"s, search_server, queries, execution::seq);
     TEST(par);
+
+    search_server.SetEvaluationMode(SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME);
+    search_server.ResetPruningStats();
+    Test("document-at-a-time"s, search_server, queries, execution::seq);
+    const auto pruning_stats = search_server.GetPruningStats();
+    cout << "postings scored: "s << pruning_stats.scored_postings
+        << ", skipped: "s << pruning_stats.skipped_postings << endl;
+    search_server.SetEvaluationMode(SearchServer::EvaluationMode::TERM_AT_A_TIME);
+
+    BenchmarkPostingLists(documents, queries);
+    BenchmarkTokenizer(documents);
+    BenchmarkProcessQueries(search_server, GenerateQueries(generator, dictionary, 2'000, 10));
+    BenchmarkAddDocuments(dictionary[0], documents);
+    BenchmarkRemoveDocuments(dictionary[0], documents);
+    BenchmarkConcurrentIngest(dictionary[0], documents, GenerateQueries(generator, dictionary, 1'000, 10));
+    BenchmarkSegmentedIngest(dictionary[0], documents);
+    BenchmarkStatusFilter(dictionary[0], documents, queries);
+    BenchmarkMatchDocuments(search_server, GenerateQueries(generator, dictionary, 20, 10));
+    BenchmarkPagedSearch(search_server, GenerateQueries(generator, dictionary, 100, 10));
+    BenchmarkSnapshot(search_server);
+    BenchmarkQueryCache(search_server, GenerateQueries(generator, dictionary, 1'000, 10), generator);
+    BenchmarkConcurrentMaps();
 }
@@ -1,8 +1,12 @@
 #pragma once
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
+using namespace std::string_literals;
+
 template <typename Iterator>
 class IteratorRange {
 public:
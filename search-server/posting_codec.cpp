@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpu_features.h"
+#include "posting_codec.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr size_t LANE_COUNT = 4;
+constexpr size_t LANE_SIZE = POSTING_BLOCK_SIZE / LANE_COUNT;
+constexpr uint32_t MAX_BIT_WIDTH = 32;
+
+// Ядра специализированы по ширине: сдвиги и номера слов известны при компиляции, цикл разворачивается.
+// Распаковка и префиксная сумма разностей идут в регистрах, номера записываются один раз
+using DecodeFunction = void (*)(const uint32_t* packed, uint32_t base, uint32_t* values);
+
+template <uint32_t BitWidth>
+constexpr uint32_t MASK = BitWidth == 32 ? UINT32_MAX : (uint32_t{ 1 } << BitWidth) - 1;
+
+template <uint32_t BitWidth>
+void DecodeScalar(const uint32_t* packed, uint32_t base, uint32_t* values) {
+    for (size_t index = 0; index < LANE_SIZE; ++index) {
+        const size_t bit = index * BitWidth;
+        const size_t word = bit / 32;
+        const uint32_t shift = bit % 32;
+        for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+            uint32_t value = packed[word * LANE_COUNT + lane] >> shift;
+            if (shift + BitWidth > 32) {
+                // shift > 0 здесь; маска лишь убирает предупреждение для ширины 0, где ветка недостижима
+                value |= packed[(word + 1) * LANE_COUNT + lane] << ((32 - shift) & 31);
+            }
+            base += value & MASK<BitWidth>;
+            values[index * LANE_COUNT + lane] = base;
+        }
+    }
+}
+
+#ifdef CPU_FEATURES_SSE2
+template <uint32_t BitWidth>
+void DecodeSse2(const uint32_t* packed, uint32_t base, uint32_t* values) {
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(MASK<BitWidth>));
+    const __m128i* words = reinterpret_cast<const __m128i*>(packed);
+    __m128i* out = reinterpret_cast<__m128i*>(values);
+    __m128i carry = _mm_set1_epi32(static_cast<int>(base));
+    for (size_t index = 0; index < LANE_SIZE; ++index) {
+        const size_t bit = index * BitWidth;
+        const size_t word = bit / 32;
+        const int shift = static_cast<int>(bit % 32);
+        __m128i value = _mm_srli_epi32(_mm_loadu_si128(words + word), shift);
+        if (shift + BitWidth > 32) {
+            value = _mm_or_si128(value, _mm_slli_epi32(_mm_loadu_si128(words + word + 1), 32 - shift));
+        }
+        value = _mm_and_si128(value, mask);
+        // Префиксная сумма по четырём значениям регистра и перенос последнего значения дальше
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+        value = _mm_add_epi32(value, carry);
+        _mm_storeu_si128(out + index, value);
+        carry = _mm_shuffle_epi32(value, 0xFF);
+    }
+}
+#endif
+
+#ifdef CPU_FEATURES_AVX2
+// За итерацию распаковываются два соседних значения каждой дорожки (8 номеров подряд):
+// у них разные сдвиги, поэтому используются vpsrlvd/vpsllvd
+template <uint32_t BitWidth>
+__attribute__((target("avx2")))
+void DecodeAvx2(const uint32_t* packed, uint32_t base, uint32_t* values) {
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(MASK<BitWidth>));
+    const __m128i* words = reinterpret_cast<const __m128i*>(packed);
+    const size_t last_word = BitWidth > 0 ? BitWidth - 1 : 0;
+    const __m256i last_value = _mm256_set1_epi32(7);
+    __m256i carry = _mm256_set1_epi32(static_cast<int>(base));
+    for (size_t index = 0; index < LANE_SIZE; index += 2) {
+        const size_t low_bit = index * BitWidth;
+        const size_t high_bit = low_bit + BitWidth;
+        const size_t low_word = low_bit / 32;
+        const size_t high_word = high_bit / 32;
+        const int low_shift = static_cast<int>(low_bit % 32);
+        const int high_shift = static_cast<int>(high_bit % 32);
+        const __m256i current = _mm256_set_m128i(_mm_loadu_si128(words + high_word), _mm_loadu_si128(words + low_word));
+        const __m256i right_shifts = _mm256_setr_epi32(low_shift, low_shift, low_shift, low_shift,
+            high_shift, high_shift, high_shift, high_shift);
+        __m256i value = _mm256_srlv_epi32(current, right_shifts);
+        if (low_shift + BitWidth > 32 || high_shift + BitWidth > 32) {
+            // Сдвиг влево на 32 бита обнуляет половину, которой следующее слово не нужно
+            const __m256i next = _mm256_set_m128i(_mm_loadu_si128(words + std::min(high_word + 1, last_word)),
+                _mm_loadu_si128(words + std::min(low_word + 1, last_word)));
+            const int low_left = low_shift + BitWidth > 32 ? 32 - low_shift : 32;
+            const int high_left = high_shift + BitWidth > 32 ? 32 - high_shift : 32;
+            const __m256i left_shifts = _mm256_setr_epi32(low_left, low_left, low_left, low_left,
+                high_left, high_left, high_left, high_left);
+            value = _mm256_or_si256(value, _mm256_sllv_epi32(next, left_shifts));
+        }
+        value = _mm256_and_si256(value, mask);
+        // Префиксная сумма: внутри половин, затем последний элемент нижней половины добавляется к верхней
+        value = _mm256_add_epi32(value, _mm256_slli_si256(value, 4));
+        value = _mm256_add_epi32(value, _mm256_slli_si256(value, 8));
+        value = _mm256_add_epi32(value,
+            _mm256_shuffle_epi32(_mm256_permute2x128_si256(value, value, 0x08), 0xFF));
+        value = _mm256_add_epi32(value, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + index * LANE_COUNT), value);
+        carry = _mm256_permutevar8x32_epi32(value, last_value);
+    }
+}
+#endif
+
+template <template <uint32_t> typename Kernel, size_t... BitWidths>
+constexpr std::array<DecodeFunction, MAX_BIT_WIDTH + 1> MakeDecodeTable(std::index_sequence<BitWidths...>) {
+    return { &Kernel<BitWidths>::Decode... };
+}
+
+template <uint32_t BitWidth>
+struct ScalarKernel {
+    static void Decode(const uint32_t* packed, uint32_t base, uint32_t* values) {
+        DecodeScalar<BitWidth>(packed, base, values);
+    }
+};
+
+constexpr auto SCALAR_DECODERS = MakeDecodeTable<ScalarKernel>(std::make_index_sequence<MAX_BIT_WIDTH + 1>());
+
+#ifdef CPU_FEATURES_SSE2
+template <uint32_t BitWidth>
+struct Sse2Kernel {
+    static void Decode(const uint32_t* packed, uint32_t base, uint32_t* values) {
+        DecodeSse2<BitWidth>(packed, base, values);
+    }
+};
+
+constexpr auto SSE2_DECODERS = MakeDecodeTable<Sse2Kernel>(std::make_index_sequence<MAX_BIT_WIDTH + 1>());
+#endif
+
+#ifdef CPU_FEATURES_AVX2
+template <uint32_t BitWidth>
+struct Avx2Kernel {
+    static void Decode(const uint32_t* packed, uint32_t base, uint32_t* values) {
+        DecodeAvx2<BitWidth>(packed, base, values);
+    }
+};
+
+constexpr auto AVX2_DECODERS = MakeDecodeTable<Avx2Kernel>(std::make_index_sequence<MAX_BIT_WIDTH + 1>());
+#endif
+
+PostingDecodeKernel GetBestKernel() {
+#ifdef CPU_FEATURES_AVX2
+    if (CpuHasAvx2()) {
+        return PostingDecodeKernel::AVX2;
+    }
+#endif
+#ifdef CPU_FEATURES_SSE2
+    return PostingDecodeKernel::SSE2;
+#else
+    return PostingDecodeKernel::SCALAR;
+#endif
+}
+
+std::atomic<PostingDecodeKernel> current_kernel = GetBestKernel();
+
+}  // namespace
+
+bool IsPostingDecodeKernelSupported(PostingDecodeKernel kernel) {
+    switch (kernel) {
+    case PostingDecodeKernel::SCALAR:
+        return true;
+    case PostingDecodeKernel::SSE2:
+#ifdef CPU_FEATURES_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case PostingDecodeKernel::AVX2:
+        return CpuHasAvx2();
+    }
+    return false;
+}
+
+PostingDecodeKernel GetPostingDecodeKernel() {
+    return current_kernel.load(std::memory_order_relaxed);
+}
+
+void SetPostingDecodeKernel(PostingDecodeKernel kernel) {
+    if (!IsPostingDecodeKernelSupported(kernel)) {
+        throw std::invalid_argument("Posting decode kernel is not supported"s);
+    }
+    current_kernel.store(kernel, std::memory_order_relaxed);
+}
+
+uint32_t PackPostingBlock(const int* documents, std::vector<uint32_t>& packed) {
+    uint32_t deltas[POSTING_BLOCK_SIZE];
+    deltas[0] = 0;
+    uint32_t max_delta = 0;
+    for (size_t i = 1; i < POSTING_BLOCK_SIZE; ++i) {
+        deltas[i] = static_cast<uint32_t>(documents[i]) - static_cast<uint32_t>(documents[i - 1]);
+        max_delta = std::max(max_delta, deltas[i]);
+    }
+    uint32_t bit_width = 0;
+    while (bit_width < 32 && (max_delta >> bit_width) != 0) {
+        ++bit_width;
+    }
+
+    const size_t offset = packed.size();
+    packed.resize(offset + bit_width * LANE_COUNT, 0);
+    uint32_t* words = packed.data() + offset;
+    for (size_t index = 0; index < LANE_SIZE; ++index) {
+        const size_t bit = index * bit_width;
+        const size_t word = bit / 32;
+        const uint32_t shift = bit % 32;
+        for (size_t lane = 0; lane < LANE_COUNT && bit_width > 0; ++lane) {
+            const uint32_t value = deltas[index * LANE_COUNT + lane];
+            words[word * LANE_COUNT + lane] |= value << shift;
+            if (shift + bit_width > 32) {
+                words[(word + 1) * LANE_COUNT + lane] |= value >> (32 - shift);
+            }
+        }
+    }
+    return bit_width;
+}
+
+void DecodePostingBlock(const uint32_t* packed, uint32_t bit_width, int first_document, int* documents) {
+    DecodePostingBlock(packed, bit_width, first_document, documents, GetPostingDecodeKernel());
+}
+
+void DecodePostingBlock(const uint32_t* packed, uint32_t bit_width, int first_document, int* documents,
+    PostingDecodeKernel kernel) {
+    uint32_t* values = reinterpret_cast<uint32_t*>(documents);
+    const uint32_t base = static_cast<uint32_t>(first_document);
+    switch (kernel) {
+#ifdef CPU_FEATURES_AVX2
+    case PostingDecodeKernel::AVX2:
+        AVX2_DECODERS[bit_width](packed, base, values);
+        return;
+#endif
+#ifdef CPU_FEATURES_SSE2
+    case PostingDecodeKernel::SSE2:
+        SSE2_DECODERS[bit_width](packed, base, values);
+        return;
+#endif
+    default:
+        SCALAR_DECODERS[bit_width](packed, base, values);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Сжатие блоков постинг-листа: разности соседних номеров документов блока упаковываются
+// по bit_width бит в «вертикальной» раскладке на 4 дорожки (значение i — в дорожке i % 4),
+// так что SIMD-распаковка сдвигает все дорожки на одно и то же число бит.
+constexpr size_t POSTING_BLOCK_SIZE = 128;
+
+enum class PostingDecodeKernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+bool IsPostingDecodeKernelSupported(PostingDecodeKernel kernel);
+// По умолчанию выбирается самое быстрое ядро, доступное процессору
+PostingDecodeKernel GetPostingDecodeKernel();
+void SetPostingDecodeKernel(PostingDecodeKernel kernel);
+
+// Упаковывает POSTING_BLOCK_SIZE возрастающих номеров в конец packed, возвращает ширину разности в битах
+uint32_t PackPostingBlock(const int* documents, std::vector<uint32_t>& packed);
+// Восстанавливает номера блока; first_document — номер первого документа из записи пропуска
+void DecodePostingBlock(const uint32_t* packed, uint32_t bit_width, int first_document, int* documents);
+void DecodePostingBlock(const uint32_t* packed, uint32_t bit_width, int first_document, int* documents,
+    PostingDecodeKernel kernel);
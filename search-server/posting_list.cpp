@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "posting_list.h"
+
+PostingList::Cursor::Cursor(const PostingList& postings)
+    : postings_(&postings) {
+    LoadSegment(0);
+}
+
+void PostingList::Cursor::Advance(int document_number) {
+    if (IsEnd() || documents_[position_] >= document_number) {
+        return;
+    }
+    if (documents_[count_ - 1] < document_number) {
+        LoadSegment(std::max(segment_ + 1, postings_->FindSegment(document_number)));
+        if (IsEnd()) {
+            return;
+        }
+    }
+    position_ = std::lower_bound(documents_ + position_, documents_ + count_, document_number) - documents_;
+}
+
+void PostingList::Cursor::LoadSegment(size_t segment) {
+    segment_ = segment;
+    position_ = 0;
+    if (segment >= postings_->GetSegmentCount()) {
+        count_ = 0;
+        return;
+    }
+    count_ = postings_->DecodeSegment(segment, documents_);
+    term_freqs_ = postings_->GetSegmentTermFreqs(segment);
+}
+
+void PostingList::Add(int document_number, double term_freq) {
+    const size_t segment_count = GetSegmentCount();
+    if (segment_count == 0 || GetSegmentLastDocument(segment_count - 1) < document_number) {
+        tail_documents_.push_back(document_number);
+        term_freqs_.push_back(static_cast<float>(term_freq));
+        max_term_freq_ = std::max<double>(max_term_freq_, term_freqs_.back());
+        if (tail_documents_.size() == POSTING_BLOCK_SIZE) {
+            SealTail();
+        }
+        return;
+    }
+
+    int documents[POSTING_BLOCK_SIZE];
+    const size_t segment = FindSegment(document_number);
+    const size_t count = DecodeSegment(segment, documents);
+    const size_t position = std::lower_bound(documents, documents + count, document_number) - documents;
+    if (documents[position] == document_number) {
+        float& stored_term_freq = term_freqs_[segment * POSTING_BLOCK_SIZE + position];
+        stored_term_freq = static_cast<float>(stored_term_freq + term_freq);
+        max_term_freq_ = std::max<double>(max_term_freq_, stored_term_freq);
+        return;
+    }
+
+    // Вставка в середину сжатого листа: лист пересобирается целиком
+    std::vector<int> all_documents;
+    std::vector<float> all_term_freqs;
+    all_documents.reserve(size() + 1);
+    all_term_freqs.reserve(size() + 1);
+    bool inserted = false;
+    ForEach([&](int current_document, double current_term_freq) {
+        if (!inserted && current_document > document_number) {
+            all_documents.push_back(document_number);
+            all_term_freqs.push_back(static_cast<float>(term_freq));
+            inserted = true;
+        }
+        all_documents.push_back(current_document);
+        all_term_freqs.push_back(static_cast<float>(current_term_freq));
+    });
+    Rebuild(all_documents, all_term_freqs);
+}
+
+void PostingList::Reserve(size_t count) {
+    term_freqs_.reserve(count);
+    blocks_.reserve(count / POSTING_BLOCK_SIZE);
+}
+
+void PostingList::ShrinkToFit() {
+    blocks_.shrink_to_fit();
+    packed_documents_.shrink_to_fit();
+    term_freqs_.shrink_to_fit();
+    tail_documents_.shrink_to_fit();
+}
+
+size_t PostingList::size() const {
+    return term_freqs_.size();
+}
+
+bool PostingList::empty() const {
+    return size() == 0;
+}
+
+double PostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+size_t PostingList::GetMemoryUsage() const {
+    return blocks_.capacity() * sizeof(Block)
+        + packed_documents_.capacity() * sizeof(uint32_t)
+        + term_freqs_.capacity() * sizeof(float)
+        + tail_documents_.capacity() * sizeof(int);
+}
+
+size_t PostingList::GetSegmentCount() const {
+    return blocks_.size() + (tail_documents_.empty() ? 0 : 1);
+}
+
+int PostingList::GetSegmentFirstDocument(size_t segment) const {
+    return segment < blocks_.size() ? blocks_[segment].first_document : tail_documents_.front();
+}
+
+int PostingList::GetSegmentLastDocument(size_t segment) const {
+    return segment < blocks_.size() ? blocks_[segment].last_document : tail_documents_.back();
+}
+
+size_t PostingList::FindSegment(int document_number) const {
+    const auto it = std::lower_bound(blocks_.begin(), blocks_.end(), document_number,
+        [](const Block& block, int id) {
+            return block.last_document < id;
+        });
+    if (it != blocks_.end()) {
+        return it - blocks_.begin();
+    }
+    return !tail_documents_.empty() && tail_documents_.back() >= document_number ? blocks_.size() : GetSegmentCount();
+}
+
+size_t PostingList::DecodeSegment(size_t segment, int* documents) const {
+    if (segment < blocks_.size()) {
+        const Block& block = blocks_[segment];
+        DecodePostingBlock(packed_documents_.data() + block.offset, block.bit_width, block.first_document, documents);
+        return POSTING_BLOCK_SIZE;
+    }
+    std::memcpy(documents, tail_documents_.data(), tail_documents_.size() * sizeof(int));
+    return tail_documents_.size();
+}
+
+const float* PostingList::GetSegmentTermFreqs(size_t segment) const {
+    return term_freqs_.data() + segment * POSTING_BLOCK_SIZE;
+}
+
+void PostingList::SealTail() {
+    const uint32_t offset = static_cast<uint32_t>(packed_documents_.size());
+    const uint32_t bit_width = PackPostingBlock(tail_documents_.data(), packed_documents_);
+    blocks_.push_back({ tail_documents_.front(), tail_documents_.back(), offset, bit_width });
+    tail_documents_.clear();
+}
+
+void PostingList::Rebuild(const std::vector<int>& documents, const std::vector<float>& term_freqs) {
+    blocks_.clear();
+    packed_documents_.clear();
+    tail_documents_.clear();
+    term_freqs_ = term_freqs;
+    max_term_freq_ = 0.0;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        tail_documents_.push_back(documents[i]);
+        max_term_freq_ = std::max<double>(max_term_freq_, term_freqs[i]);
+        if (tail_documents_.size() == POSTING_BLOCK_SIZE) {
+            SealTail();
+        }
+    }
+    blocks_.shrink_to_fit();
+    packed_documents_.shrink_to_fit();
+    term_freqs_.shrink_to_fit();
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "posting_codec.h"
+
+// Постинг-лист слова, упорядоченный по внутреннему номеру документа.
+// Полные блоки по POSTING_BLOCK_SIZE постингов хранятся сжатыми: разности номеров упакованы по ширине
+// наибольшей разности, запись пропуска блока хранит первый и последний номер. Последний неполный блок
+// не сжат и пополняется в конец. Частота слова квантуется до float: относительная погрешность ~6e-8
+// укладывается в допуск релевантности 1e-6.
+// Постинги удалённых документов убирает RemoveIf, пересобирая лист.
+class PostingList {
+public:
+    // Курсор для обхода документ-за-документом: блоки распаковываются по одному
+    class Cursor {
+    public:
+        explicit Cursor(const PostingList& postings);
+
+        bool IsEnd() const {
+            return position_ == count_;
+        }
+
+        int GetDocumentNumber() const {
+            return documents_[position_];
+        }
+
+        double GetTermFreq() const {
+            return term_freqs_[position_];
+        }
+
+        void Next() {
+            if (++position_ == count_) {
+                LoadSegment(segment_ + 1);
+            }
+        }
+
+        // Переходит к первому постингу с номером документа не меньше заданного; целые блоки пропускаются по записям пропуска
+        void Advance(int document_number);
+
+    private:
+        const PostingList* postings_;
+        size_t segment_ = 0;
+        size_t position_ = 0;
+        size_t count_ = 0;
+        const float* term_freqs_ = nullptr;
+        int documents_[POSTING_BLOCK_SIZE];
+
+        void LoadSegment(size_t segment);
+    };
+
+    void Add(int document_number, double term_freq);
+    void Reserve(size_t count);
+    // Освобождает запас, оставшийся после Reserve с завышенной оценкой
+    void ShrinkToFit();
+
+    size_t size() const;
+    bool empty() const;
+    size_t GetMemoryUsage() const;
+    // Верхняя граница term_freq по списку
+    double GetMaxTermFreq() const;
+
+    template <typename Func>
+    void ForEach(Func func) const;
+    // Обходит постинги документов с внутренними номерами из [first_document, last_document)
+    template <typename Func>
+    void ForEachInRange(int first_document, int last_document, Func func) const;
+
+    // Убирает постинги документов, для которых is_removed(document_number) истинно, и пересобирает список
+    template <typename Predicate>
+    void RemoveIf(Predicate is_removed);
+
+private:
+    struct Block {
+        int first_document;
+        int last_document;
+        uint32_t offset;
+        uint32_t bit_width;
+    };
+
+    std::vector<Block> blocks_;
+    std::vector<uint32_t> packed_documents_;
+    std::vector<float> term_freqs_;
+    std::vector<int> tail_documents_;
+    double max_term_freq_ = 0.0;
+
+    // Сегмент — сжатый блок или несжатый хвост, который идёт последним
+    size_t GetSegmentCount() const;
+    int GetSegmentFirstDocument(size_t segment) const;
+    int GetSegmentLastDocument(size_t segment) const;
+    // Первый сегмент, последний номер которого не меньше заданного
+    size_t FindSegment(int document_number) const;
+    size_t DecodeSegment(size_t segment, int* documents) const;
+    const float* GetSegmentTermFreqs(size_t segment) const;
+
+    void SealTail();
+    void Rebuild(const std::vector<int>& documents, const std::vector<float>& term_freqs);
+};
+
+template <typename Func>
+void PostingList::ForEach(Func func) const {
+    ForEachInRange(0, std::numeric_limits<int>::max(), func);
+}
+
+template <typename Func>
+void PostingList::ForEachInRange(int first_document, int last_document, Func func) const {
+    int documents[POSTING_BLOCK_SIZE];
+    const size_t segment_count = GetSegmentCount();
+    for (size_t segment = FindSegment(first_document);
+        segment < segment_count && GetSegmentFirstDocument(segment) < last_document; ++segment) {
+        const size_t count = DecodeSegment(segment, documents);
+        const float* term_freqs = GetSegmentTermFreqs(segment);
+        size_t i = documents[0] < first_document
+            ? std::lower_bound(documents, documents + count, first_document) - documents
+            : 0;
+        for (; i < count && documents[i] < last_document; ++i) {
+            func(documents[i], static_cast<double>(term_freqs[i]));
+        }
+    }
+}
+
+template <typename Predicate>
+void PostingList::RemoveIf(Predicate is_removed) {
+    std::vector<int> documents;
+    std::vector<float> term_freqs;
+    documents.reserve(size());
+    term_freqs.reserve(size());
+    ForEach([&](int document_number, double term_freq) {
+        if (!is_removed(document_number)) {
+            documents.push_back(document_number);
+            term_freqs.push_back(static_cast<float>(term_freq));
+        }
+    });
+    Rebuild(documents, term_freqs);
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "posting_segment.h"
+
+using namespace std::string_literals;
+
+PostingSegment::PostingSegment(int first_document, int last_document, std::vector<TermId> terms,
+    std::vector<PostingList> postings)
+    : first_document_(first_document)
+    , last_document_(last_document)
+    , terms_(std::move(terms))
+    , postings_(std::move(postings))
+{
+    if (terms_.size() != postings_.size() || first_document_ > last_document_
+        || !std::is_sorted(terms_.begin(), terms_.end())) {
+        throw std::invalid_argument("Invalid posting segment"s);
+    }
+    for (const PostingList& postings : postings_) {
+        posting_count_ += postings.size();
+    }
+}
+
+int PostingSegment::GetFirstDocument() const {
+    return first_document_;
+}
+
+int PostingSegment::GetLastDocument() const {
+    return last_document_;
+}
+
+size_t PostingSegment::GetDocumentCount() const {
+    return static_cast<size_t>(last_document_ - first_document_);
+}
+
+size_t PostingSegment::GetPostingCount() const {
+    return posting_count_;
+}
+
+size_t PostingSegment::GetMemoryUsage() const {
+    size_t memory_usage = terms_.capacity() * sizeof(TermId) + postings_.capacity() * sizeof(PostingList);
+    for (const PostingList& postings : postings_) {
+        memory_usage += postings.GetMemoryUsage();
+    }
+    return memory_usage;
+}
+
+const PostingList* PostingSegment::Find(TermId term_id) const {
+    const auto it = std::lower_bound(terms_.begin(), terms_.end(), term_id);
+    if (it == terms_.end() || *it != term_id) {
+        return nullptr;
+    }
+    return &postings_[it - terms_.begin()];
+}
+
+// Слияние по словам: для каждого слова из объединения словарей списки сегментов дописываются по порядку,
+// так что номера документов в новом списке остаются возрастающими
+std::shared_ptr<const PostingSegment> PostingSegment::Merge(
+    const std::vector<std::shared_ptr<const PostingSegment>>& segments, const DocumentBitset& live_documents) {
+    if (segments.empty()) {
+        throw std::invalid_argument("Nothing to merge"s);
+    }
+    for (size_t i = 1; i < segments.size(); ++i) {
+        if (segments[i - 1]->last_document_ != segments[i]->first_document_) {
+            throw std::invalid_argument("Merged segments must be adjacent"s);
+        }
+    }
+
+    std::vector<TermId> all_terms;
+    for (const auto& segment : segments) {
+        all_terms.insert(all_terms.end(), segment->terms_.begin(), segment->terms_.end());
+    }
+    std::sort(all_terms.begin(), all_terms.end());
+    all_terms.erase(std::unique(all_terms.begin(), all_terms.end()), all_terms.end());
+
+    std::vector<TermId> terms;
+    std::vector<PostingList> postings;
+    terms.reserve(all_terms.size());
+    postings.reserve(all_terms.size());
+    for (const TermId term_id : all_terms) {
+        size_t posting_count = 0;
+        for (const auto& segment : segments) {
+            if (const PostingList* segment_postings = segment->Find(term_id)) {
+                posting_count += segment_postings->size();
+            }
+        }
+        PostingList merged;
+        merged.Reserve(posting_count);
+        for (const auto& segment : segments) {
+            if (const PostingList* segment_postings = segment->Find(term_id)) {
+                segment_postings->ForEach([&merged, &live_documents](int document_number, double term_freq) {
+                    if (live_documents.Test(document_number)) {
+                        merged.Add(document_number, term_freq);
+                    }
+                });
+            }
+        }
+        if (!merged.empty()) {
+            if (merged.size() < posting_count) {
+                merged.ShrinkToFit();
+            }
+            terms.push_back(term_id);
+            postings.push_back(std::move(merged));
+        }
+    }
+    return std::make_shared<const PostingSegment>(segments.front()->first_document_, segments.back()->last_document_,
+        std::move(terms), std::move(postings));
+}
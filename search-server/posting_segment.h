@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "document_bitset.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+
+// Неизменяемый сегмент индекса: сжатые постинг-листы слов для документов с внутренними номерами
+// из [first_document, last_document). Слова упорядочены по TermId, список слова ищется двоичным поиском.
+// После создания сегмент только читается, поэтому его могут одновременно обходить запросы и фоновое слияние
+class PostingSegment {
+public:
+    PostingSegment(int first_document, int last_document, std::vector<TermId> terms, std::vector<PostingList> postings);
+
+    int GetFirstDocument() const;
+    int GetLastDocument() const;
+    size_t GetDocumentCount() const;
+    size_t GetPostingCount() const;
+    size_t GetMemoryUsage() const;
+
+    // Постинг-лист слова или nullptr, если слова в сегменте нет
+    const PostingList* Find(TermId term_id) const;
+
+    // Сливает соседние сегменты (по возрастанию номеров документов) в один, отбрасывая постинги
+    // документов, не отмеченных в live_documents
+    static std::shared_ptr<const PostingSegment> Merge(const std::vector<std::shared_ptr<const PostingSegment>>& segments,
+        const DocumentBitset& live_documents);
+
+private:
+    int first_document_;
+    int last_document_;
+    std::vector<TermId> terms_;
+    std::vector<PostingList> postings_;
+    size_t posting_count_ = 0;
+};
@@ -1,32 +1,58 @@
 #include <algorithm>
 #include <execution>
+#include <stdexcept>
 #include <vector>
 #include <string>
-#include <list>
 
 #include "search_server.h"
 #include "process_queries.h"
 
+using namespace std::string_literals;
+
+JoinedDocuments::JoinedDocuments(std::vector<Document> documents, std::vector<size_t> offsets)
+    : documents_(std::move(documents))
+    , offsets_(std::move(offsets)) {
+}
+
+JoinedDocuments::Iterator JoinedDocuments::begin() const {
+    return documents_.begin();
+}
+
+JoinedDocuments::Iterator JoinedDocuments::end() const {
+    return documents_.end();
+}
+
+size_t JoinedDocuments::size() const {
+    return documents_.size();
+}
+
+bool JoinedDocuments::empty() const {
+    return documents_.empty();
+}
+
+size_t JoinedDocuments::GetQueryCount() const {
+    return offsets_.size() - 1;
+}
+
+IteratorRange<JoinedDocuments::Iterator> JoinedDocuments::GetQueryDocuments(size_t query_index) const {
+    if (query_index >= GetQueryCount()) {
+        throw std::out_of_range("Query index is out of range"s);
+    }
+    return { documents_.begin() + offsets_[query_index], documents_.begin() + offsets_[query_index + 1] };
+}
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) {
 
-    std::vector<std::vector<Document>> result_of_queries(queries.size());
-    std::transform(std::execution::par, queries.begin(), queries.end(), result_of_queries.begin(),
-        [&search_server](const std::string& query) { return search_server.FindTopDocuments(query); });
-    return result_of_queries;
+    return search_server.FindTopDocumentsBatch(std::execution::par, queries);
 }
 
-std::list<Document> ProcessQueriesJoined(
+JoinedDocuments ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) {
 
-    std::list<Document> list_documents_result;
-    for (const auto& documents : ProcessQueries(search_server, queries))
-    {
-        std::list<Document> list_documents(make_move_iterator(documents.begin()), make_move_iterator(documents.end()));
-        list_documents_result.splice(list_documents_result.end(), std::move(list_documents));
-    }
-
-    return list_documents_result;
+    std::vector<size_t> offsets;
+    std::vector<Document> documents = search_server.FindTopDocumentsBatchJoined(std::execution::par, queries, offsets);
+    return { std::move(documents), std::move(offsets) };
 }
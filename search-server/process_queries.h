@@ -2,15 +2,36 @@
 
 #include <algorithm>
 #include <execution>
-#include <list>
+#include <vector>
 
+#include "paginator.h"
 #include "search_server.h"
 
+// Результаты пакета запросов одним массивом без промежуточных списков:
+// документы i-го запроса занимают полуинтервал [offsets[i], offsets[i + 1])
+class JoinedDocuments {
+public:
+    using Iterator = std::vector<Document>::const_iterator;
+
+    JoinedDocuments(std::vector<Document> documents, std::vector<size_t> offsets);
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    size_t GetQueryCount() const;
+    IteratorRange<Iterator> GetQueryDocuments(size_t query_index) const;
+
+private:
+    std::vector<Document> documents_;
+    std::vector<size_t> offsets_;
+};
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
-std::list<Document> ProcessQueriesJoined(
+JoinedDocuments ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
-
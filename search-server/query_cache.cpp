@@ -0,0 +1,84 @@
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "query_cache.h"
+
+QueryCache::QueryCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+void QueryCache::SetCapacity(size_t capacity) {
+    std::lock_guard guard(mutex_);
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+}
+
+size_t QueryCache::GetCapacity() const {
+    std::lock_guard guard(mutex_);
+    return capacity_;
+}
+
+bool QueryCache::Find(const Key& key, std::vector<Document>& result) {
+    std::lock_guard guard(mutex_);
+    if (capacity_ == 0) {
+        return false;
+    }
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    result = it->second->second;
+    return true;
+}
+
+void QueryCache::Insert(Key key, const std::vector<Document>& result) {
+    std::lock_guard guard(mutex_);
+    if (capacity_ == 0 || index_.count(key) > 0) {
+        return;
+    }
+    if (entries_.size() == capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+    entries_.emplace_front(std::move(key), result);
+    index_.emplace(entries_.front().first, entries_.begin());
+}
+
+void QueryCache::Clear() {
+    std::lock_guard guard(mutex_);
+    index_.clear();
+    entries_.clear();
+}
+
+QueryCache::Stats QueryCache::GetStats() const {
+    std::lock_guard guard(mutex_);
+    return { hits_, misses_, entries_.size() };
+}
+
+void QueryCache::ResetStats() {
+    std::lock_guard guard(mutex_);
+    hits_ = 0;
+    misses_ = 0;
+}
+
+size_t QueryCache::KeyHash::operator()(const Key& key) const {
+    uint64_t hash = static_cast<uint64_t>(key.status) * 0x9E3779B97F4A7C15ULL + key.max_result_count;
+    const auto mix = [&hash](uint64_t value) {
+        hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    };
+    for (const TermId term_id : key.plus_terms) {
+        mix(term_id);
+    }
+    mix(UINT32_MAX);
+    for (const TermId term_id : key.minus_terms) {
+        mix(term_id);
+    }
+    return static_cast<size_t>(hash);
+}
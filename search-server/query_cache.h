@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "term_dictionary.h"
+
+// Кеш результатов поиска с вытеснением давно не использованных записей (LRU).
+// Ключ — нормализованный запрос: отсортированные номера плюс- и минус-слов, статус и число документов в выдаче.
+// Любое изменение индекса меняет число документов, а значит, IDF всех слов, поэтому кеш сбрасывается целиком.
+class QueryCache {
+public:
+    struct Key {
+        std::vector<TermId> plus_terms;
+        std::vector<TermId> minus_terms;
+        DocumentStatus status;
+        size_t max_result_count;
+
+        bool operator==(const Key& other) const {
+            return status == other.status && max_result_count == other.max_result_count
+                && plus_terms == other.plus_terms && minus_terms == other.minus_terms;
+        }
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t size = 0;
+    };
+
+    // capacity — наибольшее число запросов в кеше; 0 отключает кеш
+    explicit QueryCache(size_t capacity = 0);
+
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const;
+
+    bool Find(const Key& key, std::vector<Document>& result);
+    void Insert(Key key, const std::vector<Document>& result);
+    void Clear();
+
+    Stats GetStats() const;
+    void ResetStats();
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    using Entry = std::pair<Key, std::vector<Document>>;
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "document_bitset.h"
+
+// Накопитель релевантности одного запроса: плотный массив по внутренним номерам документов,
+// список затронутых документов и маска исключённых (минус-слова или отказ предиката).
+// Массивы переиспользуются между запросами одного потока, очищаются только затронутые ячейки.
+class RelevanceAccumulator {
+public:
+    static RelevanceAccumulator& ForCurrentThread(size_t document_count) {
+        thread_local RelevanceAccumulator accumulator;
+        accumulator.Prepare(document_count);
+        return accumulator;
+    }
+
+    void Prepare(size_t document_count) {
+        for (const int document_number : touched_) {
+            relevance_[document_number] = 0.0;
+            touched_bits_.Reset(document_number);
+            excluded_bits_.Reset(document_number);
+        }
+        for (const int document_number : excluded_) {
+            excluded_bits_.Reset(document_number);
+        }
+        touched_.clear();
+        excluded_.clear();
+        if (relevance_.size() < document_count) {
+            relevance_.resize(document_count, 0.0);
+            touched_bits_.Resize(document_count);
+            excluded_bits_.Resize(document_count);
+        }
+    }
+
+    void Exclude(int document_number) {
+        excluded_bits_.Set(document_number);
+        excluded_.push_back(document_number);
+    }
+
+    bool IsExcluded(int document_number) const {
+        return excluded_bits_.Test(document_number);
+    }
+
+    // Возвращает true, если документ встретился в запросе впервые
+    bool Touch(int document_number) {
+        if (touched_bits_.Test(document_number)) {
+            return false;
+        }
+        touched_bits_.Set(document_number);
+        touched_.push_back(document_number);
+        return true;
+    }
+
+    void Add(int document_number, double relevance) {
+        relevance_[document_number] += relevance;
+    }
+
+    double GetRelevance(int document_number) const {
+        return relevance_[document_number];
+    }
+
+    const std::vector<int>& GetTouched() const {
+        return touched_;
+    }
+
+private:
+    std::vector<double> relevance_;
+    DocumentBitset touched_bits_;
+    DocumentBitset excluded_bits_;
+    std::vector<int> touched_;
+    std::vector<int> excluded_;
+};
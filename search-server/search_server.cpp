@@ -6,13 +6,17 @@
 #include <string_view>
 #include <execution>
 #include <type_traits>
+#include <unordered_map>
+#include <exception>
+#include <map>
+#include <set>
 
 #include "search_server.h"
 #include "string_processing.h"
 #include "read_input_functions.h"
 
 SearchServer::SearchServer(std::string_view stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text))
+    : stop_words_(ParseStopWords(stop_words_text))
 {
 }
 
@@ -21,19 +25,266 @@ SearchServer::SearchServer(const std::string& stop_words_text)
 {
 }
 
+SearchServer::SearchServer(SnapshotReader& reader)
+    : SearchServer(reader.ReadStrings())
+{
+    for (const std::string_view term : reader.ReadStrings()) {
+        term_dictionary_.Intern(term);
+    }
+    const size_t term_count = term_dictionary_.size();
+
+    size_t count = 0;
+    const uint64_t* posting_offsets = reader.ReadArray<uint64_t>(count);
+    if (count != term_count + 1) {
+        throw std::runtime_error("Snapshot is corrupted"s);
+    }
+    size_t posting_count = 0;
+    const int32_t* posting_documents = reader.ReadArray<int32_t>(posting_count);
+    const double* posting_freqs = reader.ReadArray<double>(count);
+    if (count != posting_count || posting_offsets[term_count] != posting_count) {
+        throw std::runtime_error("Snapshot is corrupted"s);
+    }
+
+    size_t document_count = 0;
+    const int32_t* ids = reader.ReadArray<int32_t>(document_count);
+    const int32_t* ratings = reader.ReadArray<int32_t>(count);
+    const int32_t* statuses = reader.ReadArray<int32_t>(count);
+    const auto texts = reader.ReadStrings();
+    size_t forward_offset_count = 0;
+    const uint64_t* forward_offsets = reader.ReadArray<uint64_t>(forward_offset_count);
+    size_t forward_count = 0;
+    const uint32_t* forward_terms = reader.ReadArray<uint32_t>(forward_count);
+    const double* forward_freqs = reader.ReadArray<double>(count);
+    if (count != forward_count || texts.size() != document_count || forward_offset_count != document_count + 1
+        || forward_offsets[document_count] != forward_count || !reader.IsEnd()) {
+        throw std::runtime_error("Snapshot is corrupted"s);
+    }
+
+    term_postings_.resize(term_count);
+    for (size_t term_id = 0; term_id < term_count; ++term_id) {
+        if (posting_offsets[term_id] > posting_offsets[term_id + 1]) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+        PostingList& postings = term_postings_[term_id];
+        postings.Reserve(posting_offsets[term_id + 1] - posting_offsets[term_id]);
+        for (uint64_t i = posting_offsets[term_id]; i < posting_offsets[term_id + 1]; ++i) {
+            if (posting_documents[i] < 0 || static_cast<size_t>(posting_documents[i]) >= document_count) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            postings.Add(posting_documents[i], posting_freqs[i]);
+        }
+    }
+    term_stats_.resize(term_count);
+    for (TermId term_id = 0; term_id < term_count; ++term_id) {
+        term_stats_[term_id].document_freq = static_cast<uint32_t>(term_postings_[term_id].size());
+        posting_count_ += term_stats_[term_id].document_freq;
+        UpdateDocumentFreq(term_id);
+    }
+
+    document_ids_by_number_.assign(ids, ids + document_count);
+    document_ratings_.assign(ratings, ratings + document_count);
+    document_statuses_.resize(document_count);
+    ResizeDocumentBitsets();
+    forward_entries_.reserve(forward_count);
+    for (size_t document_number = 0; document_number < document_count; ++document_number) {
+        const int document_id = ids[document_number];
+        const auto [it, inserted] = documents_.emplace(document_id, DocumentData{ document_texts_.Store(texts[document_number]),
+            static_cast<int>(document_number), forward_entries_.size(), 0 });
+        if (document_id < 0 || !inserted || statuses[document_number] < static_cast<int32_t>(DocumentStatus::ACTUAL)
+            || statuses[document_number] > static_cast<int32_t>(DocumentStatus::REMOVED)
+            || forward_offsets[document_number] > forward_offsets[document_number + 1]) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+        document_statuses_[document_number] = static_cast<DocumentStatus>(statuses[document_number]);
+        MarkDocumentLive(static_cast<int>(document_number), document_statuses_[document_number]);
+        document_ids_.insert(document_ids_.end(), document_id);
+        for (uint64_t i = forward_offsets[document_number]; i < forward_offsets[document_number + 1]; ++i) {
+            if (forward_terms[i] >= term_count) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            forward_entries_.push_back({ forward_terms[i], static_cast<float>(forward_freqs[i]) });
+        }
+        DocumentData& document_data = it->second;
+        document_data.term_count = static_cast<uint32_t>(forward_entries_.size() - document_data.forward_offset);
+        SortForwardEntries(forward_entries_.data() + document_data.forward_offset,
+            forward_entries_.data() + forward_entries_.size());
+    }
+    UpdateDocumentCount();
+    // Загруженный индекс сразу становится одним неизменяемым сегментом
+    memory_terms_.resize(term_count);
+    std::iota(memory_terms_.begin(), memory_terms_.end(), 0);
+    SealMemorySegment();
+}
+
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
-    const auto [it, inserted_word] = documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, std::string(document) });
-    const auto words = SplitIntoWordsNoStop(it->second.text);
-    const double inv_word_count = 1.0 / words.size();
-    for (const std::string_view word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        frequencies_[document_id][word] += inv_word_count;
+    GetStatusDocuments(status);
+    const auto word_freqs = ComputeWordFreqs(document);
+    const auto [it, inserted_word] = documents_.emplace(document_id, DocumentData{ document_texts_.Store(document),
+        static_cast<int>(document_ids_by_number_.size()), forward_entries_.size(), static_cast<uint32_t>(word_freqs.size()) });
+    const int document_number = it->second.document_number;
+    for (const auto& [word, term_freq] : word_freqs) {
+        const TermId term_id = term_dictionary_.Intern(word);
+        if (term_id == term_postings_.size()) {
+            term_postings_.emplace_back();
+            term_stats_.emplace_back();
+        }
+        if (term_postings_[term_id].empty()) {
+            memory_terms_.push_back(term_id);
+        }
+        term_postings_[term_id].Add(document_number, term_freq);
+        ++term_stats_[term_id].document_freq;
+        UpdateDocumentFreq(term_id);
+        forward_entries_.push_back({ term_id, static_cast<float>(term_freq) });
     }
+    SortForwardEntries(forward_entries_.data() + it->second.forward_offset, forward_entries_.data() + forward_entries_.size());
     document_ids_.insert(document_id);
+    AppendDocumentMetadata(document_id, ComputeAverageRating(ratings), status);
+    ResizeDocumentBitsets();
+    MarkDocumentLive(document_number, status);
+    posting_count_ += word_freqs.size();
+    UpdateDocumentCount();
+    query_cache_.Clear();
+    index_version_ = NewIndexVersion();
+    MaintainSegments();
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocuments(const ExecutionPolicy& policy, const std::vector<NewDocument>& documents) {
+    std::set<int> batch_ids;
+    for (const NewDocument& document : documents) {
+        if (document.id < 0 || documents_.count(document.id) > 0 || !batch_ids.insert(document.id).second) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+        GetStatusDocuments(document.status);
+    }
+
+    // Частичный индекс непрерывной части пакета: свой словарь и постинги в локальных номерах слов
+    struct PartialIndex {
+        size_t first_document = 0;
+        size_t last_document = 0;
+        TermDictionary terms;
+        std::vector<std::vector<std::pair<int, double>>> postings;
+        std::vector<std::vector<std::pair<TermId, double>>> document_terms;
+        std::vector<TermId> global_term_ids;
+        std::exception_ptr error;
+    };
+
+    size_t partition_count = 1;
+    if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+        partition_count = std::max<size_t>(1, std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()) * 4,
+            documents.size() / MIN_DOCUMENTS_PER_INGEST_PARTITION));
+    }
+    const int first_document_number = static_cast<int>(document_ids_by_number_.size());
+    std::vector<PartialIndex> partial_indexes(partition_count);
+    for (size_t partition = 0; partition < partition_count; ++partition) {
+        partial_indexes[partition].first_document = documents.size() * partition / partition_count;
+        partial_indexes[partition].last_document = documents.size() * (partition + 1) / partition_count;
+    }
+
+    std::for_each(policy, partial_indexes.begin(), partial_indexes.end(), [&](PartialIndex& index) {
+        try {
+            index.document_terms.reserve(index.last_document - index.first_document);
+            for (size_t i = index.first_document; i < index.last_document; ++i) {
+                const int document_number = first_document_number + static_cast<int>(i);
+                auto& document_terms = index.document_terms.emplace_back();
+                for (const auto& [word, term_freq] : ComputeWordFreqs(documents[i].text)) {
+                    const TermId term_id = index.terms.Intern(word);
+                    if (term_id == index.postings.size()) {
+                        index.postings.emplace_back();
+                    }
+                    index.postings[term_id].emplace_back(document_number, term_freq);
+                    document_terms.emplace_back(term_id, term_freq);
+                }
+            }
+        }
+        catch (...) {
+            index.error = std::current_exception();
+        }
+    });
+    for (const PartialIndex& index : partial_indexes) {
+        if (index.error) {
+            std::rethrow_exception(index.error);
+        }
+    }
 
+    // Дальше исключения (кроме нехватки памяти) невозможны, индекс меняется
+    for (PartialIndex& index : partial_indexes) {
+        index.global_term_ids.resize(index.terms.size());
+        for (TermId term_id = 0; term_id < index.terms.size(); ++term_id) {
+            index.global_term_ids[term_id] = term_dictionary_.Intern(index.terms.GetTerm(term_id));
+        }
+    }
+    term_postings_.resize(term_dictionary_.size());
+    term_stats_.resize(term_dictionary_.size());
+
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const NewDocument& document = documents[i];
+        documents_.emplace(document.id, DocumentData{ document_texts_.Store(document.text),
+            AppendDocumentMetadata(document.id, ComputeAverageRating(document.ratings), document.status), 0, 0 });
+        document_ids_.insert(document.id);
+    }
+    ResizeDocumentBitsets();
+    for (size_t i = 0; i < documents.size(); ++i) {
+        MarkDocumentLive(first_document_number + static_cast<int>(i), documents[i].status);
+    }
+
+    // Части пакета сливаются по порядку, поэтому постинги дописываются в конец списков;
+    // внутри части слова различны, и списки заполняются параллельно
+    for (const PartialIndex& index : partial_indexes) {
+        for (const TermId global_term_id : index.global_term_ids) {
+            if (term_postings_[global_term_id].empty()) {
+                memory_terms_.push_back(global_term_id);
+            }
+        }
+    }
+    for (PartialIndex& index : partial_indexes) {
+        std::vector<TermId> local_terms(index.terms.size());
+        std::iota(local_terms.begin(), local_terms.end(), 0);
+        std::for_each(policy, local_terms.begin(), local_terms.end(), [this, &index](TermId term_id) {
+            const TermId global_term_id = index.global_term_ids[term_id];
+            PostingList& postings = term_postings_[global_term_id];
+            for (const auto& [document_number, term_freq] : index.postings[term_id]) {
+                postings.Add(document_number, term_freq);
+            }
+            term_stats_[global_term_id].document_freq += static_cast<uint32_t>(index.postings[term_id].size());
+            UpdateDocumentFreq(global_term_id);
+        });
+    }
+
+    // Участки прямого индекса размечаются по порядку документов и заполняются параллельно
+    const size_t first_forward_entry = forward_entries_.size();
+    size_t forward_entry_count = first_forward_entry;
+    for (const PartialIndex& index : partial_indexes) {
+        for (size_t i = index.first_document; i < index.last_document; ++i) {
+            DocumentData& document_data = documents_.at(documents[i].id);
+            document_data.forward_offset = forward_entry_count;
+            document_data.term_count = static_cast<uint32_t>(index.document_terms[i - index.first_document].size());
+            forward_entry_count += document_data.term_count;
+        }
+    }
+    forward_entries_.resize(forward_entry_count);
+    std::for_each(policy, partial_indexes.begin(), partial_indexes.end(), [&](const PartialIndex& index) {
+        for (size_t i = index.first_document; i < index.last_document; ++i) {
+            ForwardEntry* const first = forward_entries_.data() + documents_.at(documents[i].id).forward_offset;
+            ForwardEntry* last = first;
+            for (const auto& [term_id, term_freq] : index.document_terms[i - index.first_document]) {
+                *last++ = { index.global_term_ids[term_id], static_cast<float>(term_freq) };
+            }
+            SortForwardEntries(first, last);
+        }
+    });
+    posting_count_ += forward_entry_count - first_forward_entry;
+    UpdateDocumentCount();
+    query_cache_.Clear();
+    index_version_ = NewIndexVersion();
+    MaintainSegments();
+}
+
+void SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    AddDocuments(std::execution::seq, documents);
 }
 
 bool SearchServer::IsStopWord(std::string_view word) const {
@@ -46,18 +297,44 @@ bool SearchServer::IsValidWord(std::string_view word) {
         });
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+// Управляющие символы проверяет сам токенизатор, поэтому отдельный проход IsValidWord не нужен
+TransparentStringSet SearchServer::ParseStopWords(std::string_view stop_words_text) {
     std::vector<std::string_view> words;
-    for (std::string_view word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word is invalid"s);
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+    if (!SplitIntoWords(stop_words_text, words)) {
+        throw std::invalid_argument("Some of stop words are invalid"s);
+    }
+    return MakeUniqueNonEmptyStrings(words);
+}
+
+void SearchServer::SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const {
+    if (!SplitIntoWords(text, words)) {
+        throw std::invalid_argument("Word is invalid"s);
+    }
+    if (!stop_words_.empty()) {
+        words.erase(std::remove_if(words.begin(), words.end(), [this](std::string_view word) {
+            return IsStopWord(word);
+            }), words.end());
+    }
+}
+
+// Слова документа без стоп-слов с частотами, по возрастанию слова.
+// Частоты считаются по отсортированным словам, без промежуточного словаря на каждый документ
+std::vector<std::pair<std::string_view, double>> SearchServer::ComputeWordFreqs(std::string_view document) const {
+    thread_local std::vector<std::string_view> words;
+    SplitIntoWordsNoStop(document, words);
+    const double inv_word_count = 1.0 / words.size();
+    std::sort(words.begin(), words.end());
+    std::vector<std::pair<std::string_view, double>> word_freqs;
+    for (auto first = words.begin(); first != words.end();) {
+        const auto last = std::find_if(first, words.end(), [first](std::string_view word) {
+            return word != *first;
+        });
+        word_freqs.emplace_back(*first, (last - first) * inv_word_count);
+        first = last;
     }
-    return words;
+    return word_freqs;
 }
+
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     int rating_sum = std::accumulate(ratings.begin(), ratings.end(), 0);
     return rating_sum / static_cast<int>(ratings.size());
@@ -73,28 +350,53 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         is_minus = true;
         word = word.substr(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    // Управляющие символы уже отсеяны токенизатором в ParseQuery
+    if (word.empty() || word[0] == '-') {
         throw std::invalid_argument("Query word is invalid");
     }
     return { word, is_minus, IsStopWord(word) };
 }
 
 
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy, std::string_view raw_query, DocumentStatus status) const {
-     return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-            {return document_status == status;
-            });    
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsByStatus(const ExecutionPolicy& policy, std::string_view raw_query,
+    DocumentStatus status, size_t max_result_count) const {
+    GetStatusDocuments(status);
+    const auto query = ParseQuery(raw_query, true);
+    const StatusFilter document_predicate{ status };
+    if (query_cache_.GetCapacity() == 0) {
+        return FindTopDocumentsForQuery(policy, query, document_predicate, max_result_count);
+    }
+    QueryCache::Key key{ query.plus_terms, query.minus_terms, status, max_result_count };
+    std::vector<Document> result;
+    if (query_cache_.Find(key, result)) {
+        return result;
+    }
+    result = FindTopDocumentsForQuery(policy, query, document_predicate, max_result_count);
+    query_cache_.Insert(std::move(key), result);
+    return result;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::par, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-        {return document_status == status;
-        });
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy, std::string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
+    return FindTopDocumentsByStatus(std::execution::seq, raw_query, status, max_result_count);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy, std::string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
+    return FindTopDocumentsByStatus(std::execution::par, raw_query, status, max_result_count);
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
 
-    return FindTopDocuments(std::execution::seq, raw_query, status);
+    return FindTopDocuments(std::execution::seq, raw_query, status, max_result_count);
+}
+
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query,
+    DocumentStatus status, size_t max_result_count) const {
+    GetStatusDocuments(status);
+    return FindTopDocuments(context, raw_query, StatusFilter{ status }, max_result_count);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy, std::string_view raw_query) const {
@@ -109,18 +411,79 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query)
     return FindTopDocuments(std::execution::seq, raw_query);
 }
 
+template <typename ExecutionPolicy>
+SearchServer::SearchPage SearchServer::FindPage(const ExecutionPolicy& policy, SearchCursor cursor, size_t limit) const {
+    if (limit == 0) {
+        throw std::invalid_argument("Page size must be positive"s);
+    }
+    GetStatusDocuments(cursor.status_);
+    const size_t page_end = cursor.offset_ + std::min(limit, std::numeric_limits<size_t>::max() - cursor.offset_);
+    const bool is_actual = cursor.ranked_ != nullptr && cursor.ranked_->index_version == index_version_;
+    if (!is_actual || (!cursor.ranked_->complete && cursor.ranked_->documents.size() < page_end)) {
+        // Отбор растёт хотя бы вдвое, поэтому при листании подряд запрос ранжируется O(log числа страниц) раз
+        const size_t ranked_count = is_actual
+            ? std::max(page_end, std::min(cursor.ranked_->documents.size(), std::numeric_limits<size_t>::max() / 2) * 2)
+            : page_end;
+        std::vector<Document> documents = FindTopDocumentsForQuery(policy, ParseQuery(cursor.raw_query_, true),
+            StatusFilter{ cursor.status_ }, ranked_count);
+        const bool complete = documents.size() < ranked_count;
+        cursor.ranked_ = std::make_shared<const RankedDocuments>(
+            RankedDocuments{ index_version_, std::move(documents), complete });
+    }
+    const std::vector<Document>& documents = cursor.ranked_->documents;
+    IteratorRange page(documents.begin() + std::min(cursor.offset_, documents.size()),
+        documents.begin() + std::min(page_end, documents.size()));
+    cursor.offset_ = page_end;
+    return { page, std::move(cursor) };
+}
+
+SearchServer::SearchPage SearchServer::FindTopDocumentsPage(std::execution::sequenced_policy, std::string_view raw_query,
+    DocumentStatus status, size_t offset, size_t limit) const {
+    SearchCursor cursor;
+    cursor.raw_query_ = raw_query;
+    cursor.status_ = status;
+    cursor.offset_ = offset;
+    return FindPage(std::execution::seq, std::move(cursor), limit);
+}
+
+SearchServer::SearchPage SearchServer::FindTopDocumentsPage(std::execution::parallel_policy, std::string_view raw_query,
+    DocumentStatus status, size_t offset, size_t limit) const {
+    SearchCursor cursor;
+    cursor.raw_query_ = raw_query;
+    cursor.status_ = status;
+    cursor.offset_ = offset;
+    return FindPage(std::execution::par, std::move(cursor), limit);
+}
+
+SearchServer::SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status,
+    size_t offset, size_t limit) const {
+    return FindTopDocumentsPage(std::execution::seq, raw_query, status, offset, limit);
+}
+
+SearchServer::SearchPage SearchServer::FindNextPage(std::execution::sequenced_policy, const SearchCursor& cursor,
+    size_t limit) const {
+    return FindPage(std::execution::seq, cursor, limit);
+}
+
+SearchServer::SearchPage SearchServer::FindNextPage(std::execution::parallel_policy, const SearchCursor& cursor,
+    size_t limit) const {
+    return FindPage(std::execution::par, cursor, limit);
+}
+
+SearchServer::SearchPage SearchServer::FindNextPage(const SearchCursor& cursor, size_t limit) const {
+    return FindNextPage(std::execution::seq, cursor, limit);
+}
+
 size_t SearchServer::GetDocumentCount() const {
     return documents_.size();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static const std::map<std::string_view, double> map = {};
-    if (documents_.count(document_id) == 0) {
-        return map;
-    }
-    else {
-        return frequencies_.at(document_id);
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        return {};
     }
+    return GetDocumentTerms(it->second);
 }
 
 const std::set<int>::const_iterator SearchServer::begin() const {
@@ -133,67 +496,684 @@ const std::set<int>::const_iterator SearchServer::end() const {
 
 template <typename ExecutionPolicy>
 void SearchServer::RemoveDocument(const ExecutionPolicy& policy, int document_id) {
-    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-        if (documents_.count(document_id) == 0)
-        {
-            return;
+    if (documents_.count(document_id) == 0) {
+        return;
+    }
+    RemoveDocuments(policy, std::vector<int>{ document_id });
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::RemoveDocuments(const ExecutionPolicy& policy, const std::vector<int>& document_ids) {
+    InstallMerge(false);
+    bool removed = false;
+    for (const int document_id : document_ids) {
+        const auto it = documents_.find(document_id);
+        if (it == documents_.end()) {
+            continue;
         }
+        const DocumentData& document_data = it->second;
+        const int document_number = document_data.document_number;
+        live_documents_.Reset(document_number);
+        status_documents_[static_cast<size_t>(document_statuses_[document_number])].Reset(document_number);
+        // Постинги в неизменяемых сегментах учитываются по сегменту, в изменяемом — по слову
+        const bool in_memory_segment = document_number >= memory_first_document_;
+        if (!in_memory_segment) {
+            const auto segment = std::upper_bound(segments_.begin(), segments_.end(), document_number,
+                [](int number, const SegmentEntry& entry) {
+                    return number < entry.segment->GetLastDocument();
+                });
+            segment->dead_postings += document_data.term_count;
+        }
+        for (size_t i = document_data.forward_offset; i < document_data.forward_offset + document_data.term_count; ++i) {
+            const TermId term_id = forward_entries_[i].term_id;
+            TermStats& stats = term_stats_[term_id];
+            --stats.document_freq;
+            if (in_memory_segment && stats.dead_postings++ == 0) {
+                dirty_terms_.push_back(term_id);
+            }
+            UpdateDocumentFreq(term_id);
+        }
+        dead_posting_count_ += document_data.term_count;
+        dead_forward_entries_ += document_data.term_count;
         document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        for (auto& doc_freq : frequencies_.at(document_id))
-        {
-            word_to_document_freqs_[doc_freq.first].erase(document_id);
+        documents_.erase(it);
+        removed = true;
+    }
+    if (!removed) {
+        return;
+    }
+    UpdateDocumentCount();
+    query_cache_.Clear();
+    index_version_ = NewIndexVersion();
+    if (dead_posting_count_ * 2 > posting_count_) {
+        CompactPostings(policy);
+    }
+    else if (!pending_merge_.result.valid()) {
+        StartMerge();
+    }
+    if (dead_forward_entries_ * 2 > forward_entries_.size()) {
+        CompactForwardIndex();
+    }
+}
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::CompactPostings(const ExecutionPolicy& policy) {
+    InstallMerge(true);
+    std::for_each(policy, dirty_terms_.begin(), dirty_terms_.end(), [this](TermId term_id) {
+        TermStats& stats = term_stats_[term_id];
+        if (stats.document_freq == 0) {
+            term_postings_[term_id] = PostingList();
         }
-        frequencies_.erase(document_id);
+        else {
+            term_postings_[term_id].RemoveIf([this](int document_number) {
+                return !live_documents_.Test(document_number);
+            });
+        }
+        stats.dead_postings = 0;
+    });
+    dirty_terms_.clear();
+    std::for_each(policy, segments_.begin(), segments_.end(), [this](SegmentEntry& entry) {
+        if (entry.dead_postings > 0) {
+            entry.segment = PostingSegment::Merge({ entry.segment }, live_documents_);
+            entry.dead_postings = 0;
+        }
+    });
+    posting_count_ -= dead_posting_count_;
+    dead_posting_count_ = 0;
+    CompactForwardIndex();
+}
+
+void SearchServer::CompactPostings() {
+    CompactPostings(std::execution::seq);
+}
+
+int SearchServer::AppendDocumentMetadata(int document_id, int rating, DocumentStatus status) {
+    document_ids_by_number_.push_back(document_id);
+    document_ratings_.push_back(rating);
+    document_statuses_.push_back(status);
+    return static_cast<int>(document_ids_by_number_.size()) - 1;
+}
+
+uint64_t SearchServer::NewIndexVersion() {
+    static std::atomic<uint64_t> last_version = 0;
+    return last_version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void SearchServer::ResizeDocumentBitsets() {
+    live_documents_.Resize(document_ids_by_number_.size());
+    for (DocumentBitset& documents : status_documents_) {
+        documents.Resize(document_ids_by_number_.size());
     }
-    else {
-        if (documents_.count(document_id) == 0)
-        {
-            return;
+}
+
+void SearchServer::MarkDocumentLive(int document_number, DocumentStatus status) {
+    live_documents_.Set(document_number);
+    status_documents_[static_cast<size_t>(status)].Set(document_number);
+}
+
+const DocumentBitset& SearchServer::GetStatusDocuments(DocumentStatus status) const {
+    const size_t index = static_cast<size_t>(status);
+    if (index >= status_documents_.size()) {
+        throw std::invalid_argument("Invalid document status"s);
+    }
+    return status_documents_[index];
+}
+
+WordFrequencies SearchServer::GetDocumentTerms(const DocumentData& document_data) const {
+    const ForwardEntry* first = forward_entries_.data() + document_data.forward_offset;
+    return WordFrequencies(first, first + document_data.term_count, term_dictionary_);
+}
+
+// Участки живых документов переписываются подряд, в порядке идентификаторов
+void SearchServer::CompactForwardIndex() {
+    if (dead_forward_entries_ == 0) {
+        return;
+    }
+    std::vector<ForwardEntry> entries;
+    entries.reserve(forward_entries_.size() - dead_forward_entries_);
+    for (auto& [document_id, document_data] : documents_) {
+        const auto first = forward_entries_.begin() + document_data.forward_offset;
+        document_data.forward_offset = entries.size();
+        entries.insert(entries.end(), first, first + document_data.term_count);
+    }
+    forward_entries_ = std::move(entries);
+    dead_forward_entries_ = 0;
+}
+
+void SearchServer::SetSegmentPolicy(size_t memory_segment_document_count, size_t merge_factor) {
+    if (memory_segment_document_count == 0 || merge_factor < 2) {
+        throw std::invalid_argument("Invalid segment policy"s);
+    }
+    memory_segment_document_count_ = memory_segment_document_count;
+    merge_factor_ = merge_factor;
+}
+
+size_t SearchServer::GetSegmentCount() const {
+    return segments_.size() + (memory_first_document_ < static_cast<int>(document_ids_by_number_.size()) ? 1 : 0);
+}
+
+void SearchServer::WaitForMerges() {
+    do {
+        InstallMerge(true);
+        StartMerge();
+    } while (pending_merge_.result.valid());
+}
+
+double SearchServer::GetMaxTermFreq(TermId term_id) const {
+    double max_term_freq = term_postings_[term_id].GetMaxTermFreq();
+    for (const SegmentEntry& entry : segments_) {
+        if (const PostingList* postings = entry.segment->Find(term_id)) {
+            max_term_freq = std::max(max_term_freq, postings->GetMaxTermFreq());
         }
-        document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        auto word_freq = std::move(frequencies_.at(document_id));
-        std::vector<std::string_view> words(word_freq.size());
-        std::transform(std::execution::par,
-            word_freq.begin(), word_freq.end(), words.begin(),
-            [](const auto w_f) {
-                return w_f.first;
+    }
+    return max_term_freq;
+}
+
+// Ярус сегмента: 0 для сегментов до memory_segment_document_count_ * merge_factor_ документов,
+// дальше каждый ярус в merge_factor_ раз крупнее
+size_t SearchServer::GetSegmentTier(const PostingSegment& segment) const {
+    size_t tier = 0;
+    for (size_t limit = memory_segment_document_count_ * merge_factor_; segment.GetDocumentCount() >= limit;
+        limit *= merge_factor_) {
+        ++tier;
+    }
+    return tier;
+}
+
+void SearchServer::MaintainSegments() {
+    InstallMerge(false);
+    if (document_ids_by_number_.size() - memory_first_document_ >= memory_segment_document_count_) {
+        SealMemorySegment();
+    }
+    if (!pending_merge_.result.valid()) {
+        StartMerge();
+    }
+}
+
+void SearchServer::SealMemorySegment() {
+    const int last_document = static_cast<int>(document_ids_by_number_.size());
+    if (memory_first_document_ == last_document) {
+        return;
+    }
+    std::sort(memory_terms_.begin(), memory_terms_.end());
+    memory_terms_.erase(std::unique(memory_terms_.begin(), memory_terms_.end()), memory_terms_.end());
+    std::vector<TermId> terms;
+    std::vector<PostingList> postings;
+    size_t dead_postings = 0;
+    for (const TermId term_id : memory_terms_) {
+        PostingList& term_postings = term_postings_[term_id];
+        dead_postings += term_stats_[term_id].dead_postings;
+        term_stats_[term_id].dead_postings = 0;
+        if (!term_postings.empty()) {
+            terms.push_back(term_id);
+            postings.push_back(std::move(term_postings));
+        }
+        term_postings = PostingList();
+    }
+    memory_terms_.clear();
+    dirty_terms_.clear();
+    segments_.push_back({ std::make_shared<const PostingSegment>(memory_first_document_, last_document,
+        std::move(terms), std::move(postings)), dead_postings });
+    memory_first_document_ = last_document;
+}
+
+// Сливаются merge_factor_ последних сегментов, если самый старый из них по ярусу не крупнее остальных:
+// при ровном потоке документов это серия одного яруса, после пакетов разного размера — выравнивание.
+// Иначе переписывается сегмент, больше половины постингов которого принадлежат удалённым документам.
+// Поток слияния получает свои копии указателей на сегменты и битсета живых документов
+void SearchServer::StartMerge() {
+    size_t first_segment = segments_.size();
+    size_t segment_count = 0;
+    if (segments_.size() >= merge_factor_) {
+        first_segment = segments_.size() - merge_factor_;
+        segment_count = merge_factor_;
+        const size_t tier = GetSegmentTier(*segments_[first_segment].segment);
+        for (size_t i = first_segment + 1; i < segments_.size(); ++i) {
+            if (GetSegmentTier(*segments_[i].segment) < tier) {
+                segment_count = 0;
+                break;
+            }
+        }
+    }
+    if (segment_count == 0) {
+        first_segment = std::find_if(segments_.begin(), segments_.end(), [](const SegmentEntry& entry) {
+            return entry.dead_postings * 2 > entry.segment->GetPostingCount();
+        }) - segments_.begin();
+        segment_count = 1;
+    }
+    if (first_segment == segments_.size()) {
+        return;
+    }
+    std::vector<std::shared_ptr<const PostingSegment>> inputs;
+    for (size_t i = first_segment; i < first_segment + segment_count; ++i) {
+        inputs.push_back(segments_[i].segment);
+    }
+    pending_merge_.first_segment = first_segment;
+    pending_merge_.segment_count = segment_count;
+    pending_merge_.result = std::async(std::launch::async,
+        [inputs = std::move(inputs), live_documents = live_documents_] {
+            return PostingSegment::Merge(inputs, live_documents);
+        });
+}
+
+// Слияние отбросило постинги документов, удалённых до его начала: они уже учтены в dead_postings входных
+// сегментов. Удалённые во время слияния остаются мёртвыми постингами нового сегмента
+void SearchServer::InstallMerge(bool wait) {
+    if (!pending_merge_.result.valid()) {
+        return;
+    }
+    if (!wait && pending_merge_.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    const std::shared_ptr<const PostingSegment> merged = pending_merge_.result.get();
+    const auto first = segments_.begin() + pending_merge_.first_segment;
+    const auto last = first + pending_merge_.segment_count;
+    size_t input_postings = 0;
+    size_t dead_postings = 0;
+    for (auto it = first; it != last; ++it) {
+        input_postings += it->segment->GetPostingCount();
+        dead_postings += it->dead_postings;
+    }
+    const size_t purged_postings = input_postings - merged->GetPostingCount();
+    posting_count_ -= purged_postings;
+    dead_posting_count_ -= purged_postings;
+    *first = { merged, dead_postings - purged_postings };
+    segments_.erase(first + 1, last);
+}
+
+namespace {
+
+// Номер младшего установленного бита (маска не равна нулю)
+int LowestBit(uint32_t mask) {
+    static constexpr int positions[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9,
+    };
+    return positions[((mask & (~mask + 1)) * 0x077CB531u) >> 27];
+}
+
+}  // namespace
+
+template <typename ExecutionPolicy>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const ExecutionPolicy& policy,
+    const std::vector<std::string>& raw_queries, DocumentStatus status, size_t max_result_count) const {
+    std::vector<std::vector<Document>> results(raw_queries.size());
+    ForEachBatchResult(policy, raw_queries, status, max_result_count, [&results](size_t query_index, TopDocuments& top_documents) {
+        results[query_index] = top_documents.Extract();
+    });
+    return results;
+}
+
+// Каждому запросу отводится участок на max_result_count документов (но не больше числа документов индекса),
+// запросы пишут в него параллельно, затем участки сдвигаются к началу массива без копий во вложенные списки
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsBatchJoined(const ExecutionPolicy& policy,
+    const std::vector<std::string>& raw_queries, std::vector<size_t>& offsets, DocumentStatus status,
+    size_t max_result_count) const {
+    const size_t slot_size = std::min(max_result_count, documents_.size());
+    std::vector<Document> documents(raw_queries.size() * slot_size);
+    std::vector<size_t> counts(raw_queries.size(), 0);
+    ForEachBatchResult(policy, raw_queries, status, max_result_count,
+        [&documents, &counts, slot_size](size_t query_index, TopDocuments& top_documents) {
+            const std::vector<Document>& query_documents = top_documents.Sort();
+            std::copy(query_documents.begin(), query_documents.end(), documents.begin() + query_index * slot_size);
+            counts[query_index] = query_documents.size();
+        });
+    offsets.assign(raw_queries.size() + 1, 0);
+    for (size_t i = 0; i < raw_queries.size(); ++i) {
+        offsets[i + 1] = offsets[i] + counts[i];
+        const auto slot = documents.begin() + i * slot_size;
+        std::move(slot, slot + counts[i], documents.begin() + offsets[i]);
+    }
+    documents.resize(offsets.back());
+    return documents;
+}
+
+template <typename ExecutionPolicy, typename ResultHandler>
+void SearchServer::ForEachBatchResult(const ExecutionPolicy& policy, const std::vector<std::string>& raw_queries,
+    DocumentStatus status, size_t max_result_count, ResultHandler handle_result) const {
+    std::vector<Query> queries(raw_queries.size());
+    std::transform(policy, raw_queries.begin(), raw_queries.end(), queries.begin(),
+        [this](const std::string& raw_query) {
+            return ParseQuery(raw_query, true);
+        });
+
+    // Слова пакета без повторов упорядочены так же, как в запросе, поэтому вклады слов
+    // в релевантность каждого запроса складываются в том же порядке, что и при одиночном поиске
+    std::vector<TermId> batch_terms;
+    for (const Query& query : queries) {
+        batch_terms.insert(batch_terms.end(), query.plus_terms.begin(), query.plus_terms.end());
+    }
+    std::sort(batch_terms.begin(), batch_terms.end());
+    batch_terms.erase(std::unique(batch_terms.begin(), batch_terms.end()), batch_terms.end());
+    std::sort(batch_terms.begin(), batch_terms.end(), [this](TermId lhs, TermId rhs) {
+        return term_dictionary_.GetTerm(lhs) < term_dictionary_.GetTerm(rhs);
+    });
+    std::unordered_map<TermId, uint32_t> term_ranks;
+    std::vector<double> inverse_document_freqs(batch_terms.size());
+    for (uint32_t rank = 0; rank < batch_terms.size(); ++rank) {
+        term_ranks.emplace(batch_terms[rank], rank);
+        inverse_document_freqs[rank] = ComputeWordInverseDocumentFreq(batch_terms[rank]);
+    }
+
+    size_t block_size = BATCH_BLOCK_SIZE;
+    if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+        const size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+        block_size = std::clamp<size_t>((queries.size() + thread_count - 1) / thread_count, 1, BATCH_BLOCK_SIZE);
+    }
+    std::vector<size_t> blocks((queries.size() + block_size - 1) / block_size);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    std::for_each(policy, blocks.begin(), blocks.end(),
+        [&](size_t block) {
+            const size_t first_query = block * block_size;
+            const size_t last_query = std::min(queries.size(), first_query + block_size);
+            std::vector<TopDocuments> top_documents(last_query - first_query, TopDocuments(max_result_count));
+            FindTopDocumentsForBlock(queries, first_query, last_query, batch_terms, inverse_document_freqs,
+                term_ranks, status, top_documents);
+            for (size_t i = 0; i < top_documents.size(); ++i) {
+                handle_result(first_query + i, top_documents[i]);
+            }
+        });
+}
+
+void SearchServer::FindTopDocumentsForBlock(const std::vector<Query>& queries, size_t first_query, size_t last_query,
+    const std::vector<TermId>& batch_terms, const std::vector<double>& inverse_document_freqs,
+    const std::unordered_map<TermId, uint32_t>& term_ranks, DocumentStatus status,
+    std::vector<TopDocuments>& top_documents) const {
+    // Для каждого слова блока — маска запросов, в которые оно входит (бит i — запрос first_query + i)
+    struct BlockTerm {
+        uint32_t term;
+        uint32_t query_mask;
+    };
+    const auto collect_terms = [&](auto get_terms, auto get_key) {
+        std::vector<BlockTerm> block_terms;
+        for (size_t i = first_query; i < last_query; ++i) {
+            for (const TermId term_id : get_terms(queries[i])) {
+                block_terms.push_back({ get_key(term_id), uint32_t{ 1 } << (i - first_query) });
+            }
+        }
+        std::sort(block_terms.begin(), block_terms.end(), [](const BlockTerm& lhs, const BlockTerm& rhs) {
+            return lhs.term < rhs.term;
+        });
+        std::vector<BlockTerm> merged;
+        for (const BlockTerm& block_term : block_terms) {
+            if (!merged.empty() && merged.back().term == block_term.term) {
+                merged.back().query_mask |= block_term.query_mask;
+            }
+            else {
+                merged.push_back(block_term);
+            }
+        }
+        return merged;
+    };
+    const auto plus_terms = collect_terms([](const Query& query) -> const std::vector<TermId>& { return query.plus_terms; },
+        [&term_ranks](TermId term_id) { return term_ranks.at(term_id); });
+    const auto minus_terms = collect_terms([](const Query& query) -> const std::vector<TermId>& { return query.minus_terms; },
+        [](TermId term_id) { return term_id; });
+
+    // Релевантность хранится по документам участка: relevance[local * BATCH_BLOCK_SIZE + номер запроса в блоке]
+    struct BatchAccumulator {
+        std::vector<double> relevance;
+        std::vector<uint32_t> touched_queries;
+        std::vector<uint32_t> minus_queries;
+        std::vector<int> touched;
+    };
+    thread_local BatchAccumulator accumulator;
+    accumulator.relevance.resize(BATCH_DOCUMENT_CHUNK * BATCH_BLOCK_SIZE, 0.0);
+    accumulator.touched_queries.resize(BATCH_DOCUMENT_CHUNK, 0);
+    accumulator.minus_queries.assign(BATCH_DOCUMENT_CHUNK, 0);
+    accumulator.touched.clear();
+
+    // Документы другого статуса отсекаются по маске статуса ещё до накопления релевантности
+    const DocumentBitset& status_documents = GetStatusDocuments(status);
+    uint64_t scored_postings = 0;
+    const int document_count = static_cast<int>(document_ids_by_number_.size());
+    for (int first_document = 0; first_document < document_count; first_document += BATCH_DOCUMENT_CHUNK) {
+        const int last_document = std::min(document_count, first_document + BATCH_DOCUMENT_CHUNK);
+        for (const BlockTerm& minus_term : minus_terms) {
+            ForEachPosting(minus_term.term, first_document, last_document, [&](int document_number, double) {
+                accumulator.minus_queries[document_number - first_document] |= minus_term.query_mask;
             });
-        std::for_each(std::execution::par, words.begin(), words.end(),
-            [&document_id, this](const auto word) {
-                word_to_document_freqs_.at(word).erase(document_id);
+        }
+        for (const BlockTerm& plus_term : plus_terms) {
+            const double inverse_document_freq = inverse_document_freqs[plus_term.term];
+            ForEachPosting(batch_terms[plus_term.term], first_document, last_document,
+                [&](int document_number, double term_freq) {
+                    ++scored_postings;
+                    const int local = document_number - first_document;
+                    uint32_t query_mask = plus_term.query_mask & ~accumulator.minus_queries[local];
+                    if (query_mask == 0 || !status_documents.Test(document_number)) {
+                        return;
+                    }
+                    if (accumulator.touched_queries[local] == 0) {
+                        accumulator.touched.push_back(local);
+                    }
+                    accumulator.touched_queries[local] |= query_mask;
+                    const double relevance = term_freq * inverse_document_freq;
+                    for (; query_mask != 0; query_mask &= query_mask - 1) {
+                        accumulator.relevance[local * BATCH_BLOCK_SIZE + LowestBit(query_mask)] += relevance;
+                    }
+                });
+        }
+        for (const int local : accumulator.touched) {
+            const int document_id = document_ids_by_number_[first_document + local];
+            const int rating = document_ratings_[first_document + local];
+            for (uint32_t query_mask = accumulator.touched_queries[local]; query_mask != 0; query_mask &= query_mask - 1) {
+                double& relevance = accumulator.relevance[local * BATCH_BLOCK_SIZE + LowestBit(query_mask)];
+                top_documents[LowestBit(query_mask)].Push({ document_id, relevance, rating });
+                relevance = 0.0;
+            }
+            accumulator.touched_queries[local] = 0;
+        }
+        accumulator.touched.clear();
+        std::fill(accumulator.minus_queries.begin(), accumulator.minus_queries.begin() + (last_document - first_document), 0);
+    }
+    scored_postings_.fetch_add(scored_postings, std::memory_order_relaxed);
+}
+
+void SearchServer::SetEvaluationMode(EvaluationMode mode) {
+    evaluation_mode_ = mode;
+}
+
+SearchServer::PruningStats SearchServer::GetPruningStats() const {
+    return { scored_postings_.load(), skipped_postings_.load() };
+}
+
+void SearchServer::ResetPruningStats() {
+    scored_postings_ = 0;
+    skipped_postings_ = 0;
+}
+
+void SearchServer::SetQueryCacheCapacity(size_t capacity) {
+    query_cache_.SetCapacity(capacity);
+}
+
+QueryCache::Stats SearchServer::GetQueryCacheStats() const {
+    return query_cache_.GetStats();
+}
+
+namespace {
+
+// Оценка памяти узлового контейнера: значение плюс три указателя и цвет узла красно-чёрного дерева
+template <typename Container>
+size_t GetNodeContainerMemoryUsage(const Container& container) {
+    return container.size() * (sizeof(typename Container::value_type) + 4 * sizeof(void*));
+}
+
+}  // namespace
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    // Внутренние номера документов в снимке плотные: пропуски от удалённых документов убираются
+    std::vector<int> snapshot_numbers(document_ids_by_number_.size(), -1);
+    std::vector<int32_t> ids;
+    std::vector<int32_t> ratings;
+    std::vector<int32_t> statuses;
+    std::vector<std::string_view> texts;
+    std::vector<uint64_t> forward_offsets = { 0 };
+    std::vector<uint32_t> forward_terms;
+    std::vector<double> forward_freqs;
+    for (size_t document_number = 0; document_number < document_ids_by_number_.size(); ++document_number) {
+        if (!live_documents_.Test(static_cast<int>(document_number))) {
+            continue;
+        }
+        const int document_id = document_ids_by_number_[document_number];
+        const DocumentData& document_data = documents_.at(document_id);
+        snapshot_numbers[document_number] = static_cast<int>(ids.size());
+        ids.push_back(document_id);
+        ratings.push_back(document_ratings_[document_number]);
+        statuses.push_back(static_cast<int32_t>(document_statuses_[document_number]));
+        texts.push_back(document_data.text);
+        const WordFrequencies document_terms = GetDocumentTerms(document_data);
+        for (const ForwardEntry* entry = document_terms.GetFirstEntry(); entry != document_terms.GetLastEntry(); ++entry) {
+            forward_terms.push_back(entry->term_id);
+            forward_freqs.push_back(entry->term_freq);
+        }
+        forward_offsets.push_back(forward_terms.size());
+    }
+
+    std::vector<std::string_view> terms(term_dictionary_.size());
+    std::vector<uint64_t> posting_offsets = { 0 };
+    std::vector<int32_t> posting_documents;
+    std::vector<double> posting_freqs;
+    for (TermId term_id = 0; term_id < term_dictionary_.size(); ++term_id) {
+        terms[term_id] = term_dictionary_.GetTerm(term_id);
+        ForEachPosting(term_id, 0, std::numeric_limits<int>::max(), [&](int document_number, double term_freq) {
+            if (!live_documents_.Test(document_number)) {
+                return;
+            }
+            posting_documents.push_back(snapshot_numbers[document_number]);
+            posting_freqs.push_back(term_freq);
+        });
+        posting_offsets.push_back(posting_documents.size());
+    }
+
+    SnapshotWriter writer;
+    writer.WriteStrings(std::vector<std::string_view>(stop_words_.begin(), stop_words_.end()));
+    writer.WriteStrings(terms);
+    writer.WriteArray(posting_offsets);
+    writer.WriteArray(posting_documents);
+    writer.WriteArray(posting_freqs);
+    writer.WriteArray(ids);
+    writer.WriteArray(ratings);
+    writer.WriteArray(statuses);
+    writer.WriteStrings(texts);
+    writer.WriteArray(forward_offsets);
+    writer.WriteArray(forward_terms);
+    writer.WriteArray(forward_freqs);
+    writer.Save(path);
+}
+
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    SnapshotReader reader(path);
+    return SearchServer(reader);
+}
+
+SearchServer::MemoryUsage SearchServer::GetMemoryUsage() const {
+    MemoryUsage usage;
+    usage.document_texts = document_texts_.GetMemoryUsage();
+    usage.terms = term_dictionary_.GetMemoryUsage() + term_stats_.capacity() * sizeof(TermStats);
+    usage.postings = term_postings_.capacity() * sizeof(PostingList);
+    for (const PostingList& postings : term_postings_) {
+        usage.postings += postings.GetMemoryUsage();
+    }
+    for (const SegmentEntry& entry : segments_) {
+        usage.postings += entry.segment->GetMemoryUsage();
+    }
+    usage.word_frequencies = forward_entries_.capacity() * sizeof(ForwardEntry);
+    usage.documents = GetNodeContainerMemoryUsage(documents_) + GetNodeContainerMemoryUsage(document_ids_)
+        + document_ids_by_number_.capacity() * sizeof(int) + document_ratings_.capacity() * sizeof(int)
+        + document_statuses_.capacity() * sizeof(DocumentStatus);
+    return usage;
+}
+
+SearchServer::SegmentedCursor::SegmentedCursor(const SearchServer& server, TermId term_id)
+    : server_(&server)
+    , term_id_(term_id)
+    , cursor_(server.term_postings_[term_id]) {
+    LoadSegment(0);
+}
+
+void SearchServer::SegmentedCursor::Advance(int document_number) {
+    if (IsEnd() || GetDocumentNumber() >= document_number) {
+        return;
+    }
+    const auto& segments = server_->segments_;
+    if (segment_ < segments.size() && segments[segment_].segment->GetLastDocument() <= document_number) {
+        const auto it = std::upper_bound(segments.begin() + segment_ + 1, segments.end(), document_number,
+            [](int number, const SegmentEntry& entry) {
+                return number < entry.segment->GetLastDocument();
             });
-        frequencies_.erase(document_id);
+        LoadSegment(it - segments.begin());
+        if (IsEnd() || GetDocumentNumber() >= document_number) {
+            return;
+        }
+    }
+    cursor_.Advance(document_number);
+    if (cursor_.IsEnd() && segment_ < segments.size()) {
+        LoadSegment(segment_ + 1);
     }
 }
 
-void SearchServer::RemoveDocument(int document_id) {
-    RemoveDocument(std::execution::seq, document_id);
+void SearchServer::SegmentedCursor::LoadSegment(size_t segment) {
+    const auto& segments = server_->segments_;
+    for (; segment < segments.size(); ++segment) {
+        if (const PostingList* postings = segments[segment].segment->Find(term_id_)) {
+            segment_ = segment;
+            cursor_ = PostingList::Cursor(*postings);
+            if (!cursor_.IsEnd()) {
+                return;
+            }
+        }
+    }
+    segment_ = segments.size();
+    cursor_ = PostingList::Cursor(server_->term_postings_[term_id_]);
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool need_sort) const
 {
     Query query;
-    auto  vector_words = SplitIntoWords(text);
+    thread_local std::vector<std::string_view> vector_words;
+    ParseQuery(text, need_sort, vector_words, query);
+    return query;
+}
+
+// Разбор в буферы вызывающего: слов в запросе единицы, поэтому они сортируются последовательно
+void SearchServer::ParseQuery(std::string_view text, bool need_sort, std::vector<std::string_view>& vector_words,
+    Query& query) const
+{
+    query.plus_terms.clear();
+    query.minus_terms.clear();
+    if (!SplitIntoWords(text, vector_words)) {
+        throw std::invalid_argument("Query word is invalid"s);
+    }
     if (need_sort)
     {
-        std::sort(std::execution::par, vector_words.begin(), vector_words.end());
-        auto last = std::unique(vector_words.begin(), vector_words.end());
-        vector_words.resize(std::distance(vector_words.begin(), last));
+        std::sort(vector_words.begin(), vector_words.end());
+        vector_words.erase(std::unique(vector_words.begin(), vector_words.end()), vector_words.end());
     }
     for (std::string_view word : vector_words) {
         const auto query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
+            const TermId term_id = term_dictionary_.Find(query_word.data);
+            if (term_id == TermDictionary::NO_TERM || term_stats_[term_id].document_freq == 0) {
+                continue;
+            }
             if (query_word.is_minus) {
-                query.minus_words.push_back(query_word.data);
+                query.minus_terms.push_back(term_id);
             }
             else {
-                query.plus_words.push_back(query_word.data);
+                query.plus_terms.push_back(term_id);
             }
         }
     }
-    return query;
 }
 
 template <typename ExecutionPolicy>
@@ -201,51 +1181,50 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     std::string_view raw_query, int document_id) const {
     if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
         const auto query = ParseQuery(raw_query, true);
-        const auto status_doc = documents_.at(document_id).status;
-        for (std::string_view word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            auto& map = word_to_document_freqs_.at(word);
-            if (map.count(document_id)) {
-                return { {}, status_doc };
+        const auto& document_data = documents_.at(document_id);
+        const DocumentStatus status = document_statuses_[document_data.document_number];
+        const WordFrequencies document_terms = GetDocumentTerms(document_data);
+        for (const TermId term_id : query.minus_terms) {
+            if (document_terms.Contains(term_id)) {
+                return { std::vector<std::string_view>{}, status };
             }
         }
         std::vector<std::string_view> matched_words;
-        for (std::string_view word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            auto& map = word_to_document_freqs_.at(word);
-            if (map.count(document_id)) {
-                matched_words.push_back(word);
+        for (const TermId term_id : query.plus_terms) {
+            if (document_terms.Contains(term_id)) {
+                matched_words.push_back(term_dictionary_.GetTerm(term_id));
             }
         }
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, status };
     }
     else {
         const auto query = ParseQuery(raw_query, false);
+        const auto& document_data = documents_.at(document_id);
+        const DocumentStatus status = document_statuses_[document_data.document_number];
+        const WordFrequencies document_terms = GetDocumentTerms(document_data);
         if (
-            any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-                [this, &document_id](std::string_view word) {
-                    return (word_to_document_freqs_.count(word) == 0) ? false
-                        : (frequencies_.at(document_id).count(word));
+            any_of(std::execution::par, query.minus_terms.begin(), query.minus_terms.end(),
+                [&document_terms](const TermId term_id) {
+                    return document_terms.Contains(term_id);
                 })
             ) {
-            return { std::vector<std::string_view>(), documents_.at(document_id).status };
+            return { std::vector<std::string_view>(), status };
         }
-        std::vector<std::string_view> matched_words(query.plus_words.size());
-        const auto last_copied_elem = copy_if(std::execution::par, move(query.plus_words.begin()), move(query.plus_words.end()), move(matched_words.begin()),
-            [this, &document_id](std::string_view word) {
-                return (word_to_document_freqs_.count(word) == 0) ? false
-                    : (word_to_document_freqs_.at(word).count(document_id));
+        std::vector<TermId> matched_terms(query.plus_terms.size());
+        const auto last_copied_elem = copy_if(std::execution::par, query.plus_terms.begin(), query.plus_terms.end(), matched_terms.begin(),
+            [&document_terms](const TermId term_id) {
+                return document_terms.Contains(term_id);
             }
         );
-        matched_words.resize(distance(matched_words.begin(), last_copied_elem));
+        std::vector<std::string_view> matched_words(distance(matched_terms.begin(), last_copied_elem));
+        std::transform(matched_terms.begin(), last_copied_elem, matched_words.begin(),
+            [this](const TermId term_id) {
+                return term_dictionary_.GetTerm(term_id);
+            });
         std::sort(std::execution::par, matched_words.begin(), matched_words.end());
         auto last = std::unique(matched_words.begin(), matched_words.end());
         matched_words.resize(std::distance(matched_words.begin(), last));
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, status };
     }
 }
 
@@ -254,6 +1233,102 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     return MatchDocument(std::execution::seq, raw_query, document_id);
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return std::log(SearchServer::GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+template <typename TargetIterator, typename Func>
+void SearchServer::IntersectPostings(TermId term_id, TargetIterator first, TargetIterator last, Func func) const {
+    SegmentedCursor cursor(*this, term_id);
+    for (TargetIterator target = first; target != last && !cursor.IsEnd(); ++target) {
+        cursor.Advance(target->first);
+        if (!cursor.IsEnd() && cursor.GetDocumentNumber() == target->first) {
+            func(target);
+        }
+    }
 }
+
+// Номера документов делятся на непрерывные части; у каждой части свои курсоры, и результаты
+// её документов заполняются только ею. Слова обходятся по возрастанию, поэтому списки совпавших слов
+// получаются упорядоченными, как у MatchDocument
+template <typename ExecutionPolicy>
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(
+    const ExecutionPolicy& policy, std::string_view raw_query, const std::vector<int>& document_ids) const {
+    const Query query = ParseQuery(raw_query, true);
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> results(document_ids.size());
+    // Пары (внутренний номер документа, позиция в результате)
+    std::vector<std::pair<int, size_t>> targets(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const int document_number = documents_.at(document_ids[i]).document_number;
+        std::get<1>(results[i]) = document_statuses_[document_number];
+        targets[i] = { document_number, i };
+    }
+    std::sort(targets.begin(), targets.end());
+
+    size_t partition_count = 1;
+    if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+        partition_count = std::max<size_t>(1, std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()) * 4,
+            targets.size() / MIN_DOCUMENTS_PER_MATCH_PARTITION));
+    }
+    std::vector<size_t> partitions(partition_count);
+    std::iota(partitions.begin(), partitions.end(), 0);
+    std::for_each(policy, partitions.begin(), partitions.end(), [&](size_t partition) {
+        const auto first = targets.begin() + targets.size() * partition / partition_count;
+        const auto last = targets.begin() + targets.size() * (partition + 1) / partition_count;
+        std::vector<char> excluded(last - first, 0);
+        for (const TermId term_id : query.minus_terms) {
+            IntersectPostings(term_id, first, last, [&excluded, first](auto target) {
+                excluded[target - first] = 1;
+            });
+        }
+        for (const TermId term_id : query.plus_terms) {
+            const std::string_view word = term_dictionary_.GetTerm(term_id);
+            IntersectPostings(term_id, first, last, [&](auto target) {
+                if (!excluded[target - first]) {
+                    std::get<0>(results[target->second]).push_back(word);
+                }
+            });
+        }
+    });
+    return results;
+}
+
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(
+    std::string_view raw_query, const std::vector<int>& document_ids) const {
+    return MatchDocuments(std::execution::seq, raw_query, document_ids);
+}
+
+// IDF = log(N / df) = log N - log df: логарифмы пересчитываются при изменении индекса, запрос только вычитает
+double SearchServer::ComputeWordInverseDocumentFreq(TermId term_id) const {
+    return log_document_count_ - term_stats_[term_id].log_document_freq;
+}
+
+void SearchServer::UpdateDocumentFreq(TermId term_id) {
+    TermStats& stats = term_stats_[term_id];
+    stats.log_document_freq = std::log(static_cast<double>(stats.document_freq));
+}
+
+void SearchServer::UpdateDocumentCount() {
+    log_document_count_ = std::log(static_cast<double>(GetDocumentCount()));
+}
+
+template std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
+    const std::execution::sequenced_policy&, std::string_view, int) const;
+template std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
+    const std::execution::parallel_policy&, std::string_view, int) const;
+template std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(
+    const std::execution::sequenced_policy&, std::string_view, const std::vector<int>&) const;
+template std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(
+    const std::execution::parallel_policy&, std::string_view, const std::vector<int>&) const;
+template void SearchServer::AddDocuments(const std::execution::sequenced_policy&, const std::vector<NewDocument>&);
+template void SearchServer::AddDocuments(const std::execution::parallel_policy&, const std::vector<NewDocument>&);
+template void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int);
+template void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int);
+template void SearchServer::RemoveDocuments(const std::execution::sequenced_policy&, const std::vector<int>&);
+template void SearchServer::RemoveDocuments(const std::execution::parallel_policy&, const std::vector<int>&);
+template void SearchServer::CompactPostings(const std::execution::sequenced_policy&);
+template void SearchServer::CompactPostings(const std::execution::parallel_policy&);
+template std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::execution::sequenced_policy&,
+    const std::vector<std::string>&, DocumentStatus, size_t) const;
+template std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::execution::parallel_policy&,
+    const std::vector<std::string>&, DocumentStatus, size_t) const;
+template std::vector<Document> SearchServer::FindTopDocumentsBatchJoined(const std::execution::sequenced_policy&,
+    const std::vector<std::string>&, std::vector<size_t>&, DocumentStatus, size_t) const;
+template std::vector<Document> SearchServer::FindTopDocumentsBatchJoined(const std::execution::parallel_policy&,
+    const std::vector<std::string>&, std::vector<size_t>&, DocumentStatus, size_t) const;
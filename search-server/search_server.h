@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <array>
 #include <execution>
 #include <cmath>
 #include <map>
@@ -11,18 +12,58 @@
 #include <type_traits>
 #include <future>
 #include <iterator>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
 
 #include "string_processing.h"
 #include "read_input_functions.h"
 #include "document.h"
-#include "concurrent_map.h"
+#include "top_documents.h"
 #include "log_duration.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+#include "relevance_accumulator.h"
+#include "document_bitset.h"
+#include "posting_segment.h"
+#include "forward_index.h"
+#include "query_cache.h"
+#include "string_arena.h"
+#include "snapshot.h"
+#include "paginator.h"
 
 using namespace std::string_literals;
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
 class SearchServer {
 public:
+    enum class EvaluationMode {
+        TERM_AT_A_TIME,
+        DOCUMENT_AT_A_TIME,
+    };
+
+    struct PruningStats {
+        uint64_t scored_postings = 0;
+        uint64_t skipped_postings = 0;
+    };
+
+    // Память индекса по составляющим, в байтах
+    struct MemoryUsage {
+        size_t document_texts = 0;
+        size_t terms = 0;
+        size_t postings = 0;
+        size_t word_frequencies = 0;
+        size_t documents = 0;
+
+        size_t GetTotal() const {
+            return document_texts + terms + postings + word_frequencies + documents;
+        }
+    };
 
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words);
@@ -31,24 +72,64 @@ public:
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Пакетное добавление: разбиение на слова и подсчёт частот идут параллельно, каждая часть пакета
+    // строит свой частичный индекс, затем частичные индексы за один проход сливаются в постинг-листы.
+    // Если хотя бы один документ некорректен, индекс не меняется
+    template <typename ExecutionPolicy>
+    void AddDocuments(const ExecutionPolicy& policy, const std::vector<NewDocument>& documents);
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
     template <typename DocumentPredicate, typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, std::string_view raw_query,
-        DocumentPredicate document_predicate) const;
+        DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query,
-        DocumentPredicate document_predicate) const;
+        DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
    
-    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, std::string_view raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(std::execution::parallel_policy, std::string_view raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy, std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
     
     std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, std::string_view raw_query) const;
     std::vector<Document> FindTopDocuments(std::execution::parallel_policy, std::string_view raw_query) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
+    // Буферы разбора и оценки запроса, принадлежащие вызывающему; один контекст — один поток
+    class QueryContext;
+
+    // Последовательный поиск в буферах контекста: после прогрева на запросах того же размера память не выделяется.
+    // Результат лежит в контексте и действителен до следующего поиска с ним. Кеш запросов не используется:
+    // ключ кеша и копия результата потребовали бы выделений
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query,
+        DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Продолжение постраничной выдачи и страница выдачи
+    class SearchCursor;
+    struct SearchPage;
+
+    // Постраничный поиск без ограничения MAX_RESULT_DOCUMENT_COUNT: отбираются лучшие offset + limit документов,
+    // страница — участок этого отбора. Отбор хранится в продолжении страницы, и следующие страницы берутся из него,
+    // пока индекс не менялся; когда отбора не хватает, он повторяется для вдвое большего числа документов.
+    // После изменения индекса продолжение ранжирует запрос заново. Для limit == 0 бросается std::invalid_argument
+    SearchPage FindTopDocumentsPage(std::execution::sequenced_policy, std::string_view raw_query, DocumentStatus status,
+        size_t offset, size_t limit) const;
+    SearchPage FindTopDocumentsPage(std::execution::parallel_policy, std::string_view raw_query, DocumentStatus status,
+        size_t offset, size_t limit) const;
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status, size_t offset, size_t limit) const;
+    SearchPage FindNextPage(std::execution::sequenced_policy, const SearchCursor& cursor, size_t limit) const;
+    SearchPage FindNextPage(std::execution::parallel_policy, const SearchCursor& cursor, size_t limit) const;
+    SearchPage FindNextPage(const SearchCursor& cursor, size_t limit) const;
+
     size_t GetDocumentCount() const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Представление действительно до следующего изменения сервера; слова перечисляются в порядке их TermId
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
     const std::set<int>::const_iterator begin() const;
     const std::set<int>::const_iterator end() const;
@@ -59,15 +140,92 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
         int document_id) const;
 
+    // Сопоставление одного запроса со многими документами: запрос разбирается один раз, а постинг-лист
+    // каждого слова пересекается с упорядоченными номерами документов, перескакивая блоки без нужных номеров.
+    // Результаты идут в порядке document_ids; для отсутствующего id бросается std::out_of_range
+    template <typename ExecutionPolicy>
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const ExecutionPolicy& policy,
+        std::string_view raw_query, const std::vector<int>& document_ids) const;
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(std::string_view raw_query,
+        const std::vector<int>& document_ids) const;
+
     template <typename ExecutionPolicy>
     void RemoveDocument(const ExecutionPolicy& policy, int document_id);
     void RemoveDocument(int document_id);
 
+    // Удаление снимает документы с учёта сразу (битовая маска живых документов, частоты слов, IDF),
+    // а их постинги остаются в списках до сжатия. Сжатие запускается само, когда мёртвых постингов
+    // больше половины, или явно через CompactPostings. Отсутствующие id пропускаются
+    template <typename ExecutionPolicy>
+    void RemoveDocuments(const ExecutionPolicy& policy, const std::vector<int>& document_ids);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    // Пересобирает постинг-листы слов удалённых документов; списки слов, не оставшихся ни в одном
+    // документе, освобождаются, а сами слова перестают находиться запросами до повторного добавления
+    template <typename ExecutionPolicy>
+    void CompactPostings(const ExecutionPolicy& policy);
+    void CompactPostings();
+
+    // Индекс разбит на сегменты по внутренним номерам документов. Новые документы попадают в небольшой
+    // изменяемый сегмент; заполненный сегмент запечатывается в неизменяемый, а merge_factor соседних
+    // неизменяемых сегментов одного яруса сливаются в фоновом потоке; там же переписываются сегменты, где больше
+    // половины постингов принадлежат удалённым документам. Готовое слияние подключается при следующем изменении
+    // индекса; запросы обходят все сегменты
+    void SetSegmentPolicy(size_t memory_segment_document_count, size_t merge_factor);
+    size_t GetSegmentCount() const;
+    // Выполняет все назревшие слияния, включая каскадные, и подключает их результаты
+    void WaitForMerges();
+
+    // Пакетный поиск: слова всех запросов разбираются один раз, IDF считается один раз на слово,
+    // а каждый постинг-лист обходится один раз для целого блока запросов
+    template <typename ExecutionPolicy>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const ExecutionPolicy& policy,
+        const std::vector<std::string>& raw_queries, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    // Пакетный поиск с результатами одним массивом: документы i-го запроса занимают [offsets[i], offsets[i + 1]).
+    // Топ каждого запроса пишется сразу в общий массив, вложенные списки результатов не создаются
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsBatchJoined(const ExecutionPolicy& policy,
+        const std::vector<std::string>& raw_queries, std::vector<size_t>& offsets,
+        DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Последовательный поиск: по умолчанию TERM_AT_A_TIME обходит постинг-листы слово за словом.
+    // DOCUMENT_AT_A_TIME обходит постинги документ за документом и пропускает документы, которые
+    // не могут попасть в топ (MaxScore); выигрывает, только когда пропускается большая часть постингов
+    void SetEvaluationMode(EvaluationMode mode);
+    PruningStats GetPruningStats() const;
+    void ResetPruningStats();
+
+    // Кеш результатов запросов по статусу; по умолчанию выключен (ёмкость 0).
+    // Запросы с пользовательским предикатом не кешируются
+    void SetQueryCacheCapacity(size_t capacity);
+    QueryCache::Stats GetQueryCacheStats() const;
+
+    MemoryUsage GetMemoryUsage() const;
+
+    // Снимок индекса в двоичном файле: стоп-слова, словарь, постинг-листы, данные документов
+    // и частоты слов по документам. Загрузка копирует готовые массивы из отображённого файла
+    // и не разбивает тексты на слова заново. Удалённые документы в снимок не попадают
+    void SaveSnapshot(const std::string& path) const;
+    static SearchServer LoadSnapshot(const std::string& path);
+
 private:
+    // Данные документа, нужные только при обращении по id. Рейтинг и статус, которые читаются
+    // при оценке каждого документа, хранятся отдельными массивами по внутреннему номеру
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
-        std::string text;
+        std::string_view text;
+        int document_number;
+        // Участок документа в прямом индексе
+        size_t forward_offset;
+        uint32_t term_count;
+    };
+
+    // Отбор лучших документов запроса для постраничной выдачи; complete — найденных документов меньше,
+    // чем отбиралось, и выдача исчерпана
+    struct RankedDocuments {
+        uint64_t index_version;
+        std::vector<Document> documents;
+        bool complete;
     };
 
     struct QueryWord {
@@ -77,34 +235,269 @@ private:
     };
 
     struct Query {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+        std::vector<TermId> plus_terms;
+        std::vector<TermId> minus_terms;
+    };
+
+    // Статистика слова по живым документам; dead_postings — постинги удалённых документов до сжатия
+    struct TermStats {
+        uint32_t document_freq = 0;
+        uint32_t dead_postings = 0;
+        double log_document_freq = 0.0;
+    };
+
+    // Неизменяемый сегмент и число постингов удалённых документов в нём
+    struct SegmentEntry {
+        std::shared_ptr<const PostingSegment> segment;
+        size_t dead_postings = 0;
+    };
+
+    // Фоновое слияние сегментов segments_[first_segment, first_segment + segment_count)
+    struct PendingMerge {
+        size_t first_segment = 0;
+        size_t segment_count = 0;
+        std::future<std::shared_ptr<const PostingSegment>> result;
+    };
+
+    // Курсор по постингам слова во всех сегментах: неизменяемые по порядку, затем изменяемый
+    class SegmentedCursor {
+    public:
+        SegmentedCursor(const SearchServer& server, TermId term_id);
+
+        bool IsEnd() const {
+            return cursor_.IsEnd();
+        }
+
+        int GetDocumentNumber() const {
+            return cursor_.GetDocumentNumber();
+        }
+
+        double GetTermFreq() const {
+            return cursor_.GetTermFreq();
+        }
+
+        void Next() {
+            cursor_.Next();
+            if (cursor_.IsEnd() && segment_ < server_->segments_.size()) {
+                LoadSegment(segment_ + 1);
+            }
+        }
+
+        void Advance(int document_number);
+
+    private:
+        const SearchServer* server_;
+        TermId term_id_;
+        size_t segment_ = 0;
+        PostingList::Cursor cursor_;
+
+        // Переходит к первому непустому списку слова начиная с заданного сегмента
+        void LoadSegment(size_t segment);
+    };
+
+    struct PrunedTermCursor {
+        SegmentedCursor cursor;
+        size_t position;
+        double inverse_document_freq;
+        double max_relevance;
+    };
+
+    // Рабочие массивы FindTopDocumentsPruned, переиспользуемые между запросами
+    struct PruningBuffers {
+        std::vector<PrunedTermCursor> terms;
+        std::vector<double> max_relevance_prefix;
+        std::vector<double> term_relevance;
     };
 
+    static constexpr int MIN_DOCUMENTS_PER_PARTITION = 2048;
+    static constexpr size_t BATCH_BLOCK_SIZE = 32;
+    static constexpr int BATCH_DOCUMENT_CHUNK = 16384;
+    static constexpr size_t MIN_DOCUMENTS_PER_INGEST_PARTITION = 256;
+    static constexpr size_t MIN_DOCUMENTS_PER_MATCH_PARTITION = 1024;
+    static constexpr size_t DEFAULT_MEMORY_SEGMENT_DOCUMENT_COUNT = 4096;
+    static constexpr size_t DEFAULT_MERGE_FACTOR = 4;
+    static constexpr size_t DOCUMENT_STATUS_COUNT = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+
+    // Предикат «документ имеет статус status». Распознаётся на этапе компиляции
+    // и заменяется проверкой маски статуса
+    struct StatusFilter {
+        DocumentStatus status;
+
+        bool operator()(int /*document_id*/, DocumentStatus document_status, int /*rating*/) const {
+            return document_status == status;
+        }
+    };
+
+    template <typename DocumentPredicate>
+    static constexpr bool IS_STATUS_FILTER = std::is_same_v<std::decay_t<DocumentPredicate>, StatusFilter>;
+
+    explicit SearchServer(SnapshotReader& reader);
+
     const TransparentStringSet stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> frequencies_;
+    StringArena document_texts_;
+    TermDictionary term_dictionary_;
+    // Изменяемый сегмент: постинг-листы по TermId для документов с номерами от memory_first_document_;
+    // memory_terms_ — слова, списки которых в нём заполнялись (возможны повторы)
+    std::vector<PostingList> term_postings_;
+    int memory_first_document_ = 0;
+    std::vector<TermId> memory_terms_;
+    std::vector<SegmentEntry> segments_;
+    PendingMerge pending_merge_;
+    size_t memory_segment_document_count_ = DEFAULT_MEMORY_SEGMENT_DOCUMENT_COUNT;
+    size_t merge_factor_ = DEFAULT_MERGE_FACTOR;
+    // Статистика слов по TermId и логарифм числа документов для IDF
+    std::vector<TermStats> term_stats_;
+    double log_document_count_ = 0.0;
+    DocumentBitset live_documents_;
+    // Живые документы каждого статуса: фильтр по статусу проверяется битом, без обращения к documents_
+    std::array<DocumentBitset, DOCUMENT_STATUS_COUNT> status_documents_;
+    // Слова с мёртвыми постингами, ждущие сжатия
+    std::vector<TermId> dirty_terms_;
+    size_t posting_count_ = 0;
+    size_t dead_posting_count_ = 0;
+    // Прямой индекс: слова всех документов подряд; участки удалённых документов освобождаются сжатием
+    std::vector<ForwardEntry> forward_entries_;
+    size_t dead_forward_entries_ = 0;
     std::map<int, DocumentData> documents_;
     std::set<int> document_ids_;
+    // Столбцы метаданных по внутреннему номеру документа; номера не переиспользуются,
+    // значения удалённых документов остаются на месте и отсекаются масками
+    std::vector<int> document_ids_by_number_;
+    std::vector<int> document_ratings_;
+    std::vector<DocumentStatus> document_statuses_;
+    EvaluationMode evaluation_mode_ = EvaluationMode::TERM_AT_A_TIME;
+    mutable std::atomic<uint64_t> scored_postings_ = 0;
+    mutable std::atomic<uint64_t> skipped_postings_ = 0;
+    mutable QueryCache query_cache_;
+    // Версия содержимого индекса, уникальная среди всех серверов процесса; меняется при добавлении и удалении
+    uint64_t index_version_ = NewIndexVersion();
+
+    static uint64_t NewIndexVersion();
+    template <typename ExecutionPolicy>
+    SearchPage FindPage(const ExecutionPolicy& policy, SearchCursor cursor, size_t limit) const;
 
     bool IsStopWord(std::string_view word) const;
     static bool IsValidWord(std::string_view word);
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    static TransparentStringSet ParseStopWords(std::string_view stop_words_text);
+    void SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const;
+    std::vector<std::pair<std::string_view, double>> ComputeWordFreqs(std::string_view document) const;
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
     QueryWord ParseQueryWord(std::string_view text) const;
     Query ParseQuery(std::string_view text, bool need_sort) const;
+    void ParseQuery(std::string_view text, bool need_sort, std::vector<std::string_view>& words, Query& query) const;
 
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    double ComputeWordInverseDocumentFreq(TermId term_id) const;
+    // Обходит постинги слова во всех сегментах для документов с номерами из [first_document, last_document)
+    template <typename Func>
+    void ForEachPosting(TermId term_id, int first_document, int last_document, Func func) const;
+    double GetMaxTermFreq(TermId term_id) const;
+    // Вызывает func(target) для элементов [first, last) пар (номер документа, ...), упорядоченных по номеру,
+    // чьи документы содержат слово
+    template <typename TargetIterator, typename Func>
+    void IntersectPostings(TermId term_id, TargetIterator first, TargetIterator last, Func func) const;
+    WordFrequencies GetDocumentTerms(const DocumentData& document_data) const;
+    // Выдаёт документу следующий внутренний номер и дописывает его метаданные в столбцы
+    int AppendDocumentMetadata(int document_id, int rating, DocumentStatus status);
+    // Растягивает маски живых документов до числа выданных номеров
+    void ResizeDocumentBitsets();
+    void MarkDocumentLive(int document_number, DocumentStatus status);
+    // Маска живых документов статуса; бросает std::invalid_argument для несуществующего статуса
+    const DocumentBitset& GetStatusDocuments(DocumentStatus status) const;
+    // Документы, которые предикат может пропустить: маска статуса для StatusFilter, иначе все живые
+    template <typename DocumentPredicate>
+    const DocumentBitset& GetCandidateDocuments(const DocumentPredicate& document_predicate) const;
+    void CompactForwardIndex();
+    size_t GetSegmentTier(const PostingSegment& segment) const;
+    void MaintainSegments();
+    void SealMemorySegment();
+    void StartMerge();
+    void InstallMerge(bool wait);
+    void UpdateDocumentFreq(TermId term_id);
+    void UpdateDocumentCount();
 
     template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> FindAllDocuments(const ExecutionPolicy& policy, const Query& query,
-        DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocumentsForQuery(const ExecutionPolicy& policy, const Query& query,
+        DocumentPredicate document_predicate, size_t max_result_count) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsByStatus(const ExecutionPolicy& policy, std::string_view raw_query,
+        DocumentStatus status, size_t max_result_count) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    void FindAllDocuments(const ExecutionPolicy& policy, const Query& query,
+        DocumentPredicate document_predicate, TopDocuments& top_documents) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query,
-        DocumentPredicate document_predicate) const;
+    void FindAllDocuments(const Query& query,
+        DocumentPredicate document_predicate, TopDocuments& top_documents) const;
+    template <typename DocumentPredicate>
+    uint64_t FindDocumentsInRange(const Query& query, DocumentPredicate& document_predicate,
+        int first_document, int last_document, TopDocuments& top_documents) const;
+    // Общая часть пакетного поиска: передаёт handle_result(номер запроса, его отбор) по мере готовности блоков;
+    // блоки обрабатываются параллельно, каждый запрос передаётся ровно один раз
+    template <typename ExecutionPolicy, typename ResultHandler>
+    void ForEachBatchResult(const ExecutionPolicy& policy, const std::vector<std::string>& raw_queries,
+        DocumentStatus status, size_t max_result_count, ResultHandler handle_result) const;
+    void FindTopDocumentsForBlock(const std::vector<Query>& queries, size_t first_query, size_t last_query,
+        const std::vector<TermId>& batch_terms, const std::vector<double>& inverse_document_freqs,
+        const std::unordered_map<TermId, uint32_t>& term_ranks, DocumentStatus status,
+        std::vector<TopDocuments>& top_documents) const;
+    template <typename DocumentPredicate>
+    void FindTopDocumentsPruned(const Query& query, DocumentPredicate document_predicate,
+        TopDocuments& top_documents, PruningBuffers& buffers) const;
+};
+
+class SearchServer::QueryContext {
+private:
+    friend class SearchServer;
+
+    std::vector<std::string_view> words_;
+    Query query_;
+    PruningBuffers pruning_buffers_;
+    TopDocuments top_documents_{ 0 };
+};
+
+class SearchServer::SearchCursor {
+public:
+    size_t GetOffset() const {
+        return offset_;
+    }
+
+    // Следующих страниц нет
+    bool IsEnd() const {
+        return ranked_ != nullptr && ranked_->complete && offset_ >= ranked_->documents.size();
+    }
+
+private:
+    friend class SearchServer;
+
+    std::string raw_query_;
+    DocumentStatus status_ = DocumentStatus::ACTUAL;
+    size_t offset_ = 0;
+    std::shared_ptr<const RankedDocuments> ranked_;
+};
+
+// Документы страницы лежат в отборе, которым владеет продолжение next; страница действительна, пока жив next
+// или его копии. Страницу можно разбить дальше через Paginate
+struct SearchServer::SearchPage {
+    IteratorRange<std::vector<Document>::const_iterator> documents;
+    SearchCursor next;
 };
 
+template <typename Func>
+void SearchServer::ForEachPosting(TermId term_id, int first_document, int last_document, Func func) const {
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), first_document,
+        [](int document_number, const SegmentEntry& entry) {
+            return document_number < entry.segment->GetLastDocument();
+        });
+    for (; it != segments_.end() && it->segment->GetFirstDocument() < last_document; ++it) {
+        if (const PostingList* postings = it->segment->Find(term_id)) {
+            postings->ForEachInRange(first_document, last_document, func);
+        }
+    }
+    if (memory_first_document_ < last_document) {
+        term_postings_[term_id].ForEachInRange(first_document, last_document, func);
+    }
+}
+
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
     : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
@@ -116,110 +509,255 @@ SearchServer::SearchServer(const StringContainer& stop_words)
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, std::string_view raw_query,
-    DocumentPredicate document_predicate) const {
-    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-        const auto query = SearchServer::ParseQuery(raw_query, true);
-        auto matched_documents = SearchServer::FindAllDocuments(policy, query, document_predicate);
-        std::sort(matched_documents.begin(), matched_documents.end(),
-            [](const Document& lhs, const Document& rhs) {
-                const double maxDifference = 1e-6;
-                return lhs.relevance > rhs.relevance
-                    || (std::abs(lhs.relevance - rhs.relevance) < maxDifference && lhs.rating > rhs.rating);
-            });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-        }
-        return matched_documents;
+    DocumentPredicate document_predicate, size_t max_result_count) const {
+    return FindTopDocumentsForQuery(policy, SearchServer::ParseQuery(raw_query, true), document_predicate, max_result_count);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsForQuery(const ExecutionPolicy& policy, const Query& query,
+    DocumentPredicate document_predicate, size_t max_result_count) const {
+    TopDocuments top_documents(max_result_count);
+    if (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>
+        && evaluation_mode_ == EvaluationMode::DOCUMENT_AT_A_TIME) {
+        thread_local PruningBuffers pruning_buffers;
+        SearchServer::FindTopDocumentsPruned(query, document_predicate, top_documents, pruning_buffers);
     }
     else {
-        const auto query = SearchServer::ParseQuery(raw_query, true);
-        auto matched_documents = SearchServer::FindAllDocuments(policy, query, document_predicate);
-        std::sort(matched_documents.begin(), matched_documents.end(),
-            [](const Document& lhs, const Document& rhs) {
-                const double maxDifference = 1e-6;
-                return lhs.relevance > rhs.relevance
-                    || (std::abs(lhs.relevance - rhs.relevance) < maxDifference && lhs.rating > rhs.rating);
-            });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-        }
-        return matched_documents;
+        SearchServer::FindAllDocuments(policy, query, document_predicate, top_documents);
+    }
+    return top_documents.Extract();
+}
+
+template <typename DocumentPredicate>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query,
+    DocumentPredicate document_predicate, size_t max_result_count) const {
+    ParseQuery(raw_query, true, context.words_, context.query_);
+    context.top_documents_.Reset(max_result_count);
+    if (evaluation_mode_ == EvaluationMode::DOCUMENT_AT_A_TIME) {
+        FindTopDocumentsPruned(context.query_, document_predicate, context.top_documents_, context.pruning_buffers_);
     }
+    else {
+        FindAllDocuments(std::execution::seq, context.query_, document_predicate, context.top_documents_);
+    }
+    return context.top_documents_.Sort();
 }
 
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
-    DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+    DocumentPredicate document_predicate, size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
 }
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindAllDocuments(const ExecutionPolicy& policy, const Query& query,
-    DocumentPredicate document_predicate) const {
+void SearchServer::FindAllDocuments(const ExecutionPolicy& policy, const Query& query,
+    DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+    const int document_count = static_cast<int>(document_ids_by_number_.size());
     if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-        std::map<int, double> document_to_relevance;
-        for (std::string_view word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                }
+        const uint64_t scored_postings = FindDocumentsInRange(query, document_predicate, 0, document_count, top_documents);
+        scored_postings_.fetch_add(scored_postings, std::memory_order_relaxed);
+    }
+    else {
+        // Каждый поток считает релевантность своего диапазона документов по всем словам запроса,
+        // поэтому блокировки не нужны; затем лучшие документы диапазонов объединяются
+        const int partition_count = std::max(1, std::min(
+            static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) * 4,
+            document_count / MIN_DOCUMENTS_PER_PARTITION));
+        std::vector<std::vector<Document>> partition_documents(partition_count);
+        std::vector<uint64_t> partition_scored_postings(partition_count);
+        std::vector<int> partitions(partition_count);
+        std::iota(partitions.begin(), partitions.end(), 0);
+        std::for_each(std::execution::par, partitions.begin(), partitions.end(),
+            [&](int partition) {
+                const int first_document = static_cast<int>(int64_t{ document_count } * partition / partition_count);
+                const int last_document = static_cast<int>(int64_t{ document_count } * (partition + 1) / partition_count);
+                TopDocuments partition_top(top_documents.GetMaxCount());
+                partition_scored_postings[partition] = FindDocumentsInRange(query, document_predicate,
+                    first_document, last_document, partition_top);
+                partition_documents[partition] = partition_top.Extract();
+            });
+        for (int partition = 0; partition < partition_count; ++partition) {
+            for (const Document& document : partition_documents[partition]) {
+                top_documents.Push(document);
             }
+            scored_postings_.fetch_add(partition_scored_postings[partition], std::memory_order_relaxed);
         }
-        for (std::string_view word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
+    }
+}
+
+template <typename DocumentPredicate>
+const DocumentBitset& SearchServer::GetCandidateDocuments(const DocumentPredicate& document_predicate) const {
+    if constexpr (IS_STATUS_FILTER<DocumentPredicate>) {
+        return GetStatusDocuments(document_predicate.status);
+    } else {
+        return live_documents_;
+    }
+}
+
+template <typename DocumentPredicate>
+uint64_t SearchServer::FindDocumentsInRange(const Query& query, DocumentPredicate& document_predicate,
+    int first_document, int last_document, TopDocuments& top_documents) const {
+    auto& accumulator = RelevanceAccumulator::ForCurrentThread(document_ids_by_number_.size());
+    const DocumentBitset& candidates = GetCandidateDocuments(document_predicate);
+    uint64_t scored_postings = 0;
+    for (const TermId term_id : query.minus_terms) {
+        ForEachPosting(term_id, first_document, last_document, [&accumulator](int document_number, double) {
+            accumulator.Exclude(document_number);
+        });
+    }
+    for (const TermId term_id : query.plus_terms) {
+        const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(term_id);
+        ForEachPosting(term_id, first_document, last_document, [&](int document_number, double term_freq) {
+            ++scored_postings;
+            if (accumulator.IsExcluded(document_number) || !candidates.Test(document_number)) {
+                return;
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+            if constexpr (!IS_STATUS_FILTER<DocumentPredicate>) {
+                if (accumulator.Touch(document_number)) {
+                    if (!document_predicate(document_ids_by_number_[document_number], document_statuses_[document_number],
+                        document_ratings_[document_number])) {
+                        accumulator.Exclude(document_number);
+                        return;
+                    }
+                }
+            } else {
+                accumulator.Touch(document_number);
             }
+            accumulator.Add(document_number, term_freq * inverse_document_freq);
+        });
+    }
+    for (const int document_number : accumulator.GetTouched()) {
+        if (!accumulator.IsExcluded(document_number)) {
+            top_documents.Push({ document_ids_by_number_[document_number], accumulator.GetRelevance(document_number),
+                document_ratings_[document_number] });
         }
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back(
-                { document_id, relevance, documents_.at(document_id).rating });
+    }
+    return scored_postings;
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const Query& query,
+    DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+    FindAllDocuments(std::execution::seq, query, document_predicate, top_documents);
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindTopDocumentsPruned(const Query& query, DocumentPredicate document_predicate,
+    TopDocuments& top_documents, PruningBuffers& buffers) const {
+    auto& accumulator = RelevanceAccumulator::ForCurrentThread(document_ids_by_number_.size());
+    const DocumentBitset& candidates = GetCandidateDocuments(document_predicate);
+    for (const TermId term_id : query.minus_terms) {
+        ForEachPosting(term_id, 0, std::numeric_limits<int>::max(), [&accumulator](int document_number, double) {
+            accumulator.Exclude(document_number);
+        });
+    }
+
+    auto& terms = buffers.terms;
+    terms.clear();
+    uint64_t total_postings = 0;
+    for (size_t position = 0; position < query.plus_terms.size(); ++position) {
+        const TermId term_id = query.plus_terms[position];
+        if (term_stats_[term_id].document_freq == 0) {
+            continue;
         }
-        return matched_documents;
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(term_id);
+        terms.push_back({ SegmentedCursor(*this, term_id), position, inverse_document_freq,
+            GetMaxTermFreq(term_id) * inverse_document_freq });
+        total_postings += term_stats_[term_id].document_freq;
+    }
+    std::sort(terms.begin(), terms.end(), [](const PrunedTermCursor& lhs, const PrunedTermCursor& rhs) {
+        return lhs.max_relevance < rhs.max_relevance;
+    });
+    // max_relevance_prefix[i] — верхняя граница релевантности документа, содержащего только слова terms[0..i]
+    auto& max_relevance_prefix = buffers.max_relevance_prefix;
+    max_relevance_prefix.resize(terms.size());
+    double max_relevance_sum = 0.0;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        max_relevance_sum += terms[i].max_relevance;
+        max_relevance_prefix[i] = max_relevance_sum;
     }
-    else {
-        ConcurrentMap<int, double> document_to_relevance(document_ids_.size());
-        std::for_each(std::execution::par,
-            query.plus_words.begin(), query.plus_words.end(),
-            [this, &document_to_relevance, &document_predicate](const std::string_view word) {
-                if (word_to_document_freqs_.count(word) > 0) {
-                    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                    for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                        const auto& document_data = documents_.at(document_id);
-                        if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                            document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-
-                        }
-                    }
-                }
-            });
-        auto document_to_relevance_res = document_to_relevance.BuildOrdinaryMap();
-        for (std::string_view word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) > 0) {
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                    document_to_relevance_res.erase(document_id);
 
+    // Вклады слов запроса складываются в исходном порядке, как при обходе слово за словом
+    auto& term_relevance = buffers.term_relevance;
+    term_relevance.assign(query.plus_terms.size(), 0.0);
+    uint64_t scored_postings = 0;
+    size_t first_essential = 0;
+    double threshold = -std::numeric_limits<double>::infinity();
+    while (first_essential < terms.size()) {
+        int document_number = std::numeric_limits<int>::max();
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            if (!terms[i].cursor.IsEnd()) {
+                document_number = std::min(document_number, terms[i].cursor.GetDocumentNumber());
+            }
+        }
+        if (document_number == std::numeric_limits<int>::max()) {
+            break;
+        }
+
+        // Курсоры сразу переводятся к следующему документу, прошедшему фильтр
+        if (!candidates.Test(document_number)) {
+            const int next_candidate = candidates.FindNext(document_number);
+            for (size_t i = first_essential; i < terms.size(); ++i) {
+                terms[i].cursor.Advance(next_candidate);
+            }
+            continue;
+        }
+
+        const bool excluded = accumulator.IsExcluded(document_number);
+        double relevance = 0.0;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            PrunedTermCursor& term = terms[i];
+            if (!term.cursor.IsEnd() && term.cursor.GetDocumentNumber() == document_number) {
+                if (!excluded) {
+                    term_relevance[term.position] = term.cursor.GetTermFreq() * term.inverse_document_freq;
+                    relevance += term_relevance[term.position];
+                    ++scored_postings;
                 }
+                term.cursor.Next();
             }
         }
-        std::vector<Document> matched_documents(document_to_relevance_res.size());
-        for (const auto [document_id, relevance] : document_to_relevance_res) {
-            matched_documents.emplace_back(std::move(document_id), std::move(relevance), std::move(documents_.at(document_id).rating));
+        if (excluded) {
+            continue;
+        }
+
+        bool pruned = false;
+        for (size_t i = first_essential; i-- > 0;) {
+            if (relevance + max_relevance_prefix[i] <= threshold) {
+                pruned = true;
+                break;
+            }
+            PrunedTermCursor& term = terms[i];
+            term.cursor.Advance(document_number);
+            if (!term.cursor.IsEnd() && term.cursor.GetDocumentNumber() == document_number) {
+                term_relevance[term.position] = term.cursor.GetTermFreq() * term.inverse_document_freq;
+                relevance += term_relevance[term.position];
+                ++scored_postings;
+            }
         }
-        return matched_documents;
+
+        if (!pruned && relevance > threshold) {
+            const int document_id = document_ids_by_number_[document_number];
+            const int rating = document_ratings_[document_number];
+            bool accepted = true;
+            if constexpr (!IS_STATUS_FILTER<DocumentPredicate>) {
+                accepted = document_predicate(document_id, document_statuses_[document_number], rating);
+            }
+            if (accepted) {
+                double exact_relevance = 0.0;
+                for (const double value : term_relevance) {
+                    exact_relevance += value;
+                }
+                top_documents.Push({ document_id, exact_relevance, rating });
+                if (top_documents.IsFull()) {
+                    threshold = top_documents.GetWorst().relevance - 2 * TopDocuments::RELEVANCE_EPSILON;
+                    while (first_essential < terms.size() && max_relevance_prefix[first_essential] <= threshold) {
+                        ++first_essential;
+                    }
+                }
+            }
+        }
+        std::fill(term_relevance.begin(), term_relevance.end(), 0.0);
     }
-}
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query,
-    DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+    scored_postings_.fetch_add(scored_postings, std::memory_order_relaxed);
+    skipped_postings_.fetch_add(total_postings - scored_postings, std::memory_order_relaxed);
 }
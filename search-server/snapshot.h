@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::string_literals;
+
+// Формат файла снимка индекса: заголовок фиксированного размера и полезная нагрузка из секций.
+// Массивы в нагрузке выровнены по 8 байт и лежат в порядке байтов машины, поэтому
+// отображённый в память файл читается без разбора: читатель возвращает указатели прямо в отображение.
+struct SnapshotHeader {
+    static constexpr char MAGIC[8] = { 'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P' };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+
+uint64_t ComputeSnapshotChecksum(const char* data, size_t size);
+
+class SnapshotWriter {
+public:
+    void WriteU64(uint64_t value);
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        WriteU64(values.size());
+        Align();
+        Append(values.data(), values.size() * sizeof(T));
+    }
+
+    // Таблица строк: смещения (count + 1) и символы подряд
+    void WriteStrings(const std::vector<std::string_view>& strings);
+
+    void Save(const std::string& path) const;
+
+private:
+    std::vector<char> payload_;
+
+    void Append(const void* data, size_t size);
+    void Align();
+};
+
+// Файл снимка, отображённый в память (или прочитанный целиком, где отображения нет)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const;
+    size_t size() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> buffer_;
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& path);
+
+    uint64_t ReadU64();
+
+    template <typename T>
+    const T* ReadArray(size_t& count) {
+        count = ReadU64();
+        Align();
+        if (count > (end_ - position_) / sizeof(T)) {
+            throw std::runtime_error("Snapshot is truncated"s);
+        }
+        const T* values = reinterpret_cast<const T*>(position_);
+        position_ += count * sizeof(T);
+        return values;
+    }
+
+    std::vector<std::string_view> ReadStrings();
+
+    bool IsEnd() const;
+
+private:
+    MappedFile file_;
+    const char* position_;
+    const char* end_;
+
+    void Align();
+};
@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include "string_arena.h"
+
+std::string_view StringArena::Store(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    char* data = nullptr;
+    if (text.size() > BLOCK_SIZE / 4) {
+        // Длинная строка получает собственный блок, чтобы не бросать остаток текущего
+        data = Allocate(text.size());
+    }
+    else {
+        if (available_ < text.size()) {
+            current_ = Allocate(BLOCK_SIZE);
+            available_ = BLOCK_SIZE;
+        }
+        data = current_;
+        current_ += text.size();
+        available_ -= text.size();
+    }
+    std::memcpy(data, text.data(), text.size());
+    return { data, text.size() };
+}
+
+size_t StringArena::GetMemoryUsage() const {
+    return allocated_bytes_ + blocks_.capacity() * sizeof(std::unique_ptr<char[]>);
+}
+
+char* StringArena::Allocate(size_t size) {
+    blocks_.push_back(std::make_unique<char[]>(size));
+    allocated_bytes_ += size;
+    return blocks_.back().get();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Хранилище строк только для добавления: строки копируются подряд в крупные блоки,
+// поэтому на строку не приходится отдельного выделения памяти, а выданные string_view
+// остаются действительными до разрушения хранилища
+class StringArena {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    std::string_view Store(std::string_view text);
+
+    // Память, выделенная под блоки
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* current_ = nullptr;
+    size_t available_ = 0;
+    size_t allocated_bytes_ = 0;
+
+    char* Allocate(size_t size);
+};
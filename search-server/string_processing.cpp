@@ -3,24 +3,163 @@
 #include <vector>
 #include <string_view>
 #include <execution>
+#include <cstdint>
+#include <stdexcept>
 
-#include "request_queue.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "cpu_features.h"
 #include "read_input_functions.h"
 #include "string_processing.h"
 
-std::vector<std::string_view> SplitIntoWords(std::string_view str) {
-    std::vector<std::string_view> result;
-    while (true) {
-        const auto space = str.find(' ');
-        result.push_back(str.substr(0, space));
-        if (space == str.npos) {
-            break;
+using namespace std::string_literals;
+
+namespace {
+
+bool IsControlChar(char c) {
+    return static_cast<unsigned char>(c) < ' ';
+}
+
+uint32_t CountTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Дочитывает текст с позиции position и добавляет последнее слово
+bool SplitIntoWordsScalar(std::string_view text, size_t position, size_t word_begin,
+    std::vector<std::string_view>& words) {
+    bool is_valid = true;
+    for (; position < text.size(); ++position) {
+        const char c = text[position];
+        if (c == ' ') {
+            words.push_back(text.substr(word_begin, position - word_begin));
+            word_begin = position + 1;
         }
-        else {
-            str.remove_prefix(space + 1);
+        else if (IsControlChar(c)) {
+            is_valid = false;
+        }
+    }
+    words.push_back(text.substr(word_begin));
+    return is_valid;
+}
+
+// Добавляет слова, заканчивающиеся на пробелах из маски блока, начинающегося с position
+void AddWordsBySpaceMask(std::string_view text, size_t position, uint32_t space_mask, size_t& word_begin,
+    std::vector<std::string_view>& words) {
+    while (space_mask != 0) {
+        const size_t space = position + CountTrailingZeros(space_mask);
+        words.push_back(text.substr(word_begin, space - word_begin));
+        word_begin = space + 1;
+        space_mask &= space_mask - 1;
+    }
+}
+
+#ifdef CPU_FEATURES_SSE2
+// Управляющий символ — байт не больше 31 без знака: min(c, 31) == c
+bool SplitIntoWordsSse2(std::string_view text, std::vector<std::string_view>& words) {
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i max_control = _mm_set1_epi8(' ' - 1);
+    __m128i controls = _mm_setzero_si128();
+    size_t position = 0;
+    size_t word_begin = 0;
+    for (; position + 16 <= text.size(); position += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + position));
+        controls = _mm_or_si128(controls, _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk));
+        const uint32_t space_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces)));
+        AddWordsBySpaceMask(text, position, space_mask, word_begin, words);
+    }
+    const bool is_valid = _mm_movemask_epi8(controls) == 0;
+    return SplitIntoWordsScalar(text, position, word_begin, words) && is_valid;
+}
+#endif
+
+#ifdef CPU_FEATURES_AVX2
+__attribute__((target("avx2")))
+bool SplitIntoWordsAvx2(std::string_view text, std::vector<std::string_view>& words) {
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i max_control = _mm256_set1_epi8(' ' - 1);
+    __m256i controls = _mm256_setzero_si256();
+    size_t position = 0;
+    size_t word_begin = 0;
+    for (; position + 32 <= text.size(); position += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + position));
+        controls = _mm256_or_si256(controls, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, max_control), chunk));
+        const uint32_t space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, spaces)));
+        AddWordsBySpaceMask(text, position, space_mask, word_begin, words);
+    }
+    const bool is_valid = _mm256_movemask_epi8(controls) == 0;
+    return SplitIntoWordsScalar(text, position, word_begin, words) && is_valid;
+}
+#endif
+
+TokenizerKernel GetBestKernel() {
+    if (CpuHasAvx2()) {
+        return TokenizerKernel::AVX2;
+    }
+#ifdef CPU_FEATURES_SSE2
+    return TokenizerKernel::SSE2;
+#else
+    return TokenizerKernel::SCALAR;
+#endif
+}
+
+const TokenizerKernel best_kernel = GetBestKernel();
+
+}  // namespace
+
+bool IsTokenizerKernelSupported(TokenizerKernel kernel) {
+    switch (kernel) {
+    case TokenizerKernel::SCALAR:
+        return true;
+    case TokenizerKernel::SSE2:
+#ifdef CPU_FEATURES_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case TokenizerKernel::AVX2:
+        return CpuHasAvx2();
+    }
+    return false;
+}
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    SplitIntoWords(text, words);
+    return words;
+}
+
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words) {
+    return SplitIntoWords(text, words, best_kernel);
+}
+
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words, TokenizerKernel kernel) {
+    words.clear();
+    switch (kernel) {
+#ifdef CPU_FEATURES_AVX2
+    case TokenizerKernel::AVX2:
+        if (best_kernel == TokenizerKernel::AVX2) {
+            return SplitIntoWordsAvx2(text, words);
         }
+        break;
+#endif
+#ifdef CPU_FEATURES_SSE2
+    case TokenizerKernel::SSE2:
+        return SplitIntoWordsSse2(text, words);
+#endif
+    case TokenizerKernel::SCALAR:
+        return SplitIntoWordsScalar(text, 0, 0, words);
+    default:
+        break;
     }
-    return result;
+    throw std::invalid_argument("Tokenizer kernel is not supported"s);
 }
 
 std::vector<std::string> SplitIntoWords(const std::string& text) {
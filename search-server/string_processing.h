@@ -1,9 +1,23 @@
 #pragma once
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
+enum class TokenizerKernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+bool IsTokenizerKernelSupported(TokenizerKernel kernel);
+
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
+// Делит текст по каждому пробелу (пустые слова между соседними пробелами сохраняются) в буфер words,
+// который очищается и переиспользуется вызывающим. За тот же проход текст проверяется на управляющие
+// символы: возвращает false, если они есть
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words, TokenizerKernel kernel);
 
 using TransparentStringSet = std::set<std::string, std::less<>>;
 
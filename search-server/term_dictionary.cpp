@@ -0,0 +1,66 @@
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "term_dictionary.h"
+
+TermId TermDictionary::Find(std::string_view term) const {
+    if (slots_.empty()) {
+        return NO_TERM;
+    }
+    return slots_[FindSlot(term, std::hash<std::string_view>{}(term))];
+}
+
+TermId TermDictionary::Intern(std::string_view term) {
+    if ((terms_.size() + 1) * 2 > slots_.size()) {
+        Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    }
+    const size_t hash = std::hash<std::string_view>{}(term);
+    const size_t slot = FindSlot(term, hash);
+    if (slots_[slot] != NO_TERM) {
+        return slots_[slot];
+    }
+    const TermId term_id = static_cast<TermId>(terms_.size());
+    terms_.push_back(storage_.Store(term));
+    hashes_.push_back(hash);
+    slots_[slot] = term_id;
+    return term_id;
+}
+
+std::string_view TermDictionary::GetTerm(TermId term_id) const {
+    return terms_[term_id];
+}
+
+size_t TermDictionary::size() const {
+    return terms_.size();
+}
+
+size_t TermDictionary::GetMemoryUsage() const {
+    return terms_.capacity() * sizeof(std::string_view)
+        + hashes_.capacity() * sizeof(size_t)
+        + slots_.capacity() * sizeof(TermId)
+        + storage_.GetMemoryUsage();
+}
+
+size_t TermDictionary::FindSlot(std::string_view term, size_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const TermId term_id = slots_[slot];
+        if (term_id == NO_TERM || (hashes_[term_id] == hash && terms_[term_id] == term)) {
+            return slot;
+        }
+    }
+}
+
+void TermDictionary::Rehash(size_t slot_count) {
+    slots_.assign(slot_count, NO_TERM);
+    const size_t mask = slot_count - 1;
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+        size_t slot = hashes_[term_id] & mask;
+        while (slots_[slot] != NO_TERM) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = term_id;
+    }
+}
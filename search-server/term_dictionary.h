@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "string_arena.h"
+
+using TermId = uint32_t;
+
+// Словарь индексированных слов: каждому слову сопоставляется плотный номер TermId.
+// Поиск по хеш-таблице с открытой адресацией (линейное пробирование) по string_view.
+// Каждое слово хранится один раз в общем хранилище строк, ключи индекса указывают в него.
+class TermDictionary {
+public:
+    static constexpr TermId NO_TERM = UINT32_MAX;
+
+    TermId Find(std::string_view term) const;
+    TermId Intern(std::string_view term);
+    std::string_view GetTerm(TermId term_id) const;
+
+    size_t size() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    StringArena storage_;
+    std::vector<std::string_view> terms_;
+    std::vector<size_t> hashes_;
+    std::vector<TermId> slots_;
+
+    size_t FindSlot(std::string_view term, size_t hash) const;
+    void Rehash(size_t slot_count);
+};
@@ -4,11 +4,29 @@
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <random>
+#include <numeric>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <limits>
+#include <cmath>
+#include <string_view>
+#include <cstdlib>
 
 #include "test_example_functions.h"
 #include "read_input_functions.h"
 #include "search_server.h"
 #include "document.h"
+#include "concurrent_map.h"
+#include "process_queries.h"
+#include "posting_list.h"
+#include "string_processing.h"
+#include "concurrent_search_server.h"
+#include "allocation_counter.h"
 
 void AddDocument(SearchServer& search_server, int document_id, std::string_view document,
     DocumentStatus status, const std::vector<int>& ratings) {
@@ -36,9 +54,11 @@ void FindTopDocuments(const SearchServer& search_server, std::string_view raw_qu
 void MatchDocuments(const SearchServer& search_server, std::string_view query) {
     try {
         std::cout << "Matching for request: "s << query << std::endl;
-        for (const int document_id : search_server) {
-            const auto [document, status] = search_server.MatchDocument(query, document_id);
-            PrintMatchDocumentResult(document_id, document, status);
+        const std::vector<int> document_ids(search_server.begin(), search_server.end());
+        const auto results = search_server.MatchDocuments(query, document_ids);
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const auto& [document, status] = results[i];
+            PrintMatchDocumentResult(document_ids[i], document, status);
         }
     }
     catch (const std::exception& e) {
@@ -334,6 +354,1380 @@ void TestRelevanceDocumentContent() {
     }
 }
 
+// Удалённый документ не находится поиском, а его идентификатор можно использовать повторно
+void TestRemoveDocumentContent() {
+    {
+        SearchServer server("and"s);
+        server.AddDocument(3, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+        server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, { 2 });
+        server.AddDocument(2, "groomed dog"s, DocumentStatus::ACTUAL, { 3 });
+        server.RemoveDocument(1);
+        ASSERT_EQUAL(server.GetDocumentCount(), 2u);
+        const auto found_docs = server.FindTopDocuments("fluffy cat"s);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 3);
+        ASSERT(server.FindTopDocuments("fluffy"s).empty());
+
+        server.AddDocument(1, "fluffy dog"s, DocumentStatus::ACTUAL, { 2 });
+        const auto found_docs1 = server.FindTopDocuments(std::execution::par, "fluffy"s);
+        ASSERT_EQUAL(found_docs1.size(), 1u);
+        ASSERT_EQUAL(found_docs1[0].id, 1);
+        ASSERT(server.GetWordFrequencies(1).count("dog"s) > 0);
+    }
+}
+
+// Слова документа остаются доступными после удаления документа, в котором они встретились впервые
+void TestMatchingAfterRemoveDocument() {
+    {
+        SearchServer server("and"s);
+        server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, { 1 });
+        server.AddDocument(2, "cat and dog"s, DocumentStatus::BANNED, { 2 });
+        server.RemoveDocument(1);
+        const auto [words, status] = server.MatchDocument("fluffy cat dog -bird"s, 2);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT_EQUAL(words[0], "cat"s);
+        ASSERT_EQUAL(words[1], "dog"s);
+        ASSERT(status == DocumentStatus::BANNED);
+        const auto [par_words, par_status] = server.MatchDocument(std::execution::par, "dog cat dog"s, 2);
+        ASSERT_EQUAL(par_words.size(), 2u);
+        ASSERT_EQUAL(par_words[0], "cat"s);
+        ASSERT_EQUAL(server.GetWordFrequencies(2).begin()->first, "cat"s);
+    }
+}
+
+// Повторные запросы к разным серверам в одном потоке не влияют друг на друга
+void TestRepeatedQueriesAcrossServers() {
+    SearchServer big_server("and"s);
+    for (int id = 0; id < 100; ++id) {
+        big_server.AddDocument(id, id % 2 == 0 ? "white cat"s : "black dog"s, DocumentStatus::ACTUAL, { id });
+    }
+    SearchServer small_server("and"s);
+    small_server.AddDocument(7, "white dog"s, DocumentStatus::ACTUAL, { 1 });
+    small_server.AddDocument(8, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+
+    for (int i = 0; i < 3; ++i) {
+        const auto big_docs = big_server.FindTopDocuments("cat -white dog"s);
+        ASSERT_EQUAL(big_docs.size(), 5u);
+        ASSERT_EQUAL(big_docs[0].id, 99);
+        const auto small_docs = small_server.FindTopDocuments("white"s);
+        ASSERT_EQUAL(small_docs.size(), 1u);
+        ASSERT_EQUAL(small_docs[0].id, 7);
+        const auto odd_docs = big_server.FindTopDocuments("cat dog"s,
+            [](int document_id, DocumentStatus, int) { return document_id % 2 == 1 && document_id < 10; });
+        ASSERT_EQUAL(odd_docs.size(), 5u);
+        ASSERT_EQUAL(odd_docs[0].id, 9);
+    }
+}
+
+// Количество возвращаемых документов задаётся при вызове, порядок выдачи сохраняется
+void TestTopDocumentsCount() {
+    SearchServer server("and"s);
+    for (int id = 0; id < 20; ++id) {
+        server.AddDocument(id, id < 10 ? "fluffy cat"s : "fluffy cat cat"s, DocumentStatus::ACTUAL, { id });
+    }
+    server.AddDocument(20, "dog"s, DocumentStatus::ACTUAL, { 0 });
+
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100).size(), 20u);
+
+    const auto found_docs = server.FindTopDocuments(std::execution::par, "cat"s, DocumentStatus::ACTUAL, 12);
+    ASSERT_EQUAL(found_docs.size(), 12u);
+    for (size_t i = 0; i < 10; ++i) {
+        ASSERT_EQUAL(found_docs[i].id, 19 - static_cast<int>(i));
+    }
+    ASSERT_EQUAL(found_docs[10].id, 9);
+    ASSERT_EQUAL(found_docs[11].id, 8);
+
+    const auto even_docs = server.FindTopDocuments("cat"s,
+        [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; }, 3);
+    ASSERT_EQUAL(even_docs.size(), 3u);
+    ASSERT_EQUAL(even_docs[0].id, 18);
+    ASSERT_EQUAL(even_docs[2].id, 14);
+}
+
+// Словарь случайных тестовых текстов
+const std::vector<std::string> RANDOM_TEXT_WORDS = {
+    "cat"s, "dog"s, "bird"s, "fish"s, "mouse"s, "horse"s, "cow"s, "goat"s, "frog"s, "duck"s,
+};
+
+// Случайные тексты из слов words, в каждом от 1 до max_word_count слов
+std::vector<std::string> MakeRandomTexts(std::mt19937& generator, const std::vector<std::string>& words,
+    int text_count, int max_word_count) {
+    std::vector<std::string> texts(text_count);
+    for (std::string& text : texts) {
+        const int word_count = std::uniform_int_distribution(1, max_word_count)(generator);
+        for (int i = 0; i < word_count; ++i) {
+            text += words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] + " "s;
+        }
+        text.pop_back();
+    }
+    return texts;
+}
+
+// Обход документ за документом с отсечением возвращает те же документы, что и обход слово за словом
+void TestDocumentAtATimeEvaluation() {
+    std::mt19937 generator(42);
+    const auto texts = MakeRandomTexts(generator, RANDOM_TEXT_WORDS, 300, 6);
+    SearchServer server("and"s);
+    for (int id = 0; id < 300; ++id) {
+        server.AddDocument(id, texts[id], id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+            { std::uniform_int_distribution(0, 3)(generator) });
+    }
+    for (int id = 0; id < 300; id += 11) {
+        server.RemoveDocument(id);
+    }
+
+    const auto odd_documents = [](int document_id, DocumentStatus, int) { return document_id % 2 == 1; };
+    for (const std::string& query : { "cat dog"s, "bird -fish"s, "cow goat horse mouse"s, "cat dog bird fish mouse horse cow goat"s, "dragon"s }) {
+        for (const size_t count : { 1u, 5u, 20u }) {
+            server.SetEvaluationMode(SearchServer::EvaluationMode::TERM_AT_A_TIME);
+            const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, count);
+            const auto expected_odd = server.FindTopDocuments(query, odd_documents, count);
+            server.SetEvaluationMode(SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME);
+            const auto found = server.FindTopDocuments(query, DocumentStatus::ACTUAL, count);
+            const auto found_odd = server.FindTopDocuments(query, odd_documents, count);
+            ASSERT_EQUAL(found.size(), expected.size());
+            ASSERT_EQUAL(found_odd.size(), expected_odd.size());
+            for (size_t i = 0; i < found.size(); ++i) {
+                ASSERT_EQUAL_HINT(found[i].id, expected[i].id, query);
+                ASSERT_EQUAL(found[i].relevance, expected[i].relevance);
+            }
+            for (size_t i = 0; i < found_odd.size(); ++i) {
+                ASSERT_EQUAL_HINT(found_odd[i].id, expected_odd[i].id, query);
+            }
+        }
+    }
+    const auto stats = server.GetPruningStats();
+    ASSERT(stats.skipped_postings > 0);
+}
+
+// Параллельный поиск по диапазонам документов возвращает то же, что и последовательный
+void TestParallelPartitionedSearch() {
+    std::mt19937 generator(7);
+    const auto texts = MakeRandomTexts(generator, RANDOM_TEXT_WORDS, 10000, 8);
+    SearchServer server("and"s);
+    for (int id = 0; id < 10000; ++id) {
+        server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, { std::uniform_int_distribution(0, 10)(generator) });
+    }
+    for (const std::string& query : { "cat dog -bird"s, "fish mouse horse cow"s, "goat frog duck -cat -dog"s }) {
+        const auto expected = server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL, 50);
+        const auto found = server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 50);
+        ASSERT_EQUAL(found.size(), expected.size());
+        for (size_t i = 0; i < found.size(); ++i) {
+            ASSERT_EQUAL_HINT(found[i].id, expected[i].id, query);
+            ASSERT_EQUAL(found[i].relevance, expected[i].relevance);
+        }
+    }
+}
+
+// Карта для параллельного накопления: прибавление, удаление, обход и извлечение значений
+void TestConcurrentMap() {
+    ConcurrentMap<int, double> accumulator(3);
+    std::vector<int> keys(5000);
+    std::iota(keys.begin(), keys.end(), -2500);
+    std::for_each(std::execution::par, keys.begin(), keys.end(), [&accumulator](int key) {
+        accumulator.Add(key, 1.0);
+        accumulator[key].ref_to_value += 2.0;
+    });
+    const ConcurrentMap<int, double>& const_accumulator = accumulator;
+    ASSERT_EQUAL(const_accumulator.size(), 5000u);
+    for (int key = -2500; key < 2500; key += 2) {
+        ASSERT(accumulator.Erase(key));
+    }
+    ASSERT(!accumulator.Erase(-2500));
+    ASSERT_EQUAL(accumulator.size(), 2500u);
+    ASSERT_EQUAL(accumulator[-2499].ref_to_value, 3.0);
+
+    std::atomic<int> visited = 0;
+    accumulator.ForEach(std::execution::par, [&visited](int key, double value) {
+        ASSERT(key % 2 != 0 && value == 3.0);
+        ++visited;
+    });
+    ASSERT_EQUAL(visited.load(), 2500);
+
+    std::map<int, double> drained;
+    accumulator.Drain(std::execution::seq, [&drained](int key, double value) {
+        drained.emplace(key, value);
+    });
+    ASSERT_EQUAL(drained.size(), 2500u);
+    ASSERT_EQUAL(accumulator.size(), 0u);
+}
+
+// Пакетный поиск возвращает для каждого запроса то же, что и одиночный
+void TestBatchQueries() {
+    std::mt19937 generator(11);
+    const std::vector<std::string>& words = RANDOM_TEXT_WORDS;
+    const auto texts = MakeRandomTexts(generator, words, 20000, 8);
+    SearchServer server("and"s);
+    for (int id = 0; id < 20000; ++id) {
+        server.AddDocument(id, texts[id], id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+            { std::uniform_int_distribution(0, 10)(generator) });
+    }
+    std::vector<std::string> queries = { "dragon"s, "cat cat dog"s, "and"s };
+    for (int i = 0; i < 70; ++i) {
+        std::string query;
+        for (int j = 0; j < 4; ++j) {
+            query += (j > 0 && std::uniform_int_distribution(0, 4)(generator) == 0 ? "-"s : ""s)
+                + words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] + " "s;
+        }
+        query.pop_back();
+        queries.push_back(query);
+    }
+    for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+        const auto seq_results = server.FindTopDocumentsBatch(std::execution::seq, queries, status, 10);
+        const auto par_results = server.FindTopDocumentsBatch(std::execution::par, queries, status, 10);
+        ASSERT_EQUAL(seq_results.size(), queries.size());
+        ASSERT_EQUAL(par_results.size(), queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto expected = server.FindTopDocuments(queries[i], status, 10);
+            ASSERT_EQUAL_HINT(seq_results[i].size(), expected.size(), queries[i]);
+            ASSERT_EQUAL_HINT(par_results[i].size(), expected.size(), queries[i]);
+            for (size_t j = 0; j < expected.size(); ++j) {
+                ASSERT_EQUAL_HINT(seq_results[i][j].id, expected[j].id, queries[i]);
+                ASSERT_EQUAL_HINT(par_results[i][j].id, expected[j].id, queries[i]);
+                ASSERT_EQUAL(seq_results[i][j].relevance, expected[j].relevance);
+            }
+        }
+    }
+}
+
+// Объединённая выдача пакета запросов совпадает с выдачей по каждому запросу и сохраняет их порядок
+void TestProcessQueriesJoined() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, { 1, 2, 8 });
+    server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, { 1, 3, 2 });
+    const std::vector<std::string> queries = { "nasty rat -not"s, "dragon"s, "not very funny nasty pet"s, "curly hair"s };
+    const auto results = ProcessQueries(server, queries);
+    const JoinedDocuments joined = ProcessQueriesJoined(server, queries);
+    ASSERT_EQUAL(joined.GetQueryCount(), queries.size());
+    ASSERT(joined.GetQueryDocuments(1).size() == 0);
+    std::vector<int> expected_ids;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto query_documents = joined.GetQueryDocuments(i);
+        ASSERT_EQUAL_HINT(query_documents.size(), results[i].size(), queries[i]);
+        size_t j = 0;
+        for (const Document& document : query_documents) {
+            ASSERT_EQUAL(document.id, results[i][j].id);
+            ASSERT_EQUAL(document.relevance, results[i][j].relevance);
+            expected_ids.push_back(document.id);
+            ++j;
+        }
+    }
+    std::vector<int> joined_ids;
+    for (const Document& document : joined) {
+        joined_ids.push_back(document.id);
+    }
+    ASSERT(joined_ids == expected_ids);
+    ASSERT_EQUAL(joined.size(), expected_ids.size());
+
+    // Участки запросов с меньшим числом результатов, чем отведено, сдвигаются без пропусков
+    std::vector<size_t> offsets;
+    const auto documents = server.FindTopDocumentsBatchJoined(std::execution::seq, queries, offsets, DocumentStatus::ACTUAL, 2);
+    const auto limited_results = server.FindTopDocumentsBatch(std::execution::seq, queries, DocumentStatus::ACTUAL, 2);
+    ASSERT_EQUAL(offsets.size(), queries.size() + 1);
+    ASSERT_EQUAL(documents.size(), offsets.back());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        ASSERT_EQUAL(offsets[i + 1] - offsets[i], limited_results[i].size());
+        for (size_t j = 0; j < limited_results[i].size(); ++j) {
+            ASSERT_EQUAL(documents[offsets[i] + j].id, limited_results[i][j].id);
+        }
+    }
+
+    const JoinedDocuments empty = ProcessQueriesJoined(server, {});
+    ASSERT(empty.empty());
+    ASSERT_EQUAL(empty.GetQueryCount(), 0u);
+    try {
+        empty.GetQueryDocuments(0);
+        ASSERT_HINT(false, "Query index must be checked"s);
+    }
+    catch (const std::out_of_range&) {
+    }
+}
+
+// Кеш результатов возвращает ту же выдачу и сбрасывается при изменении индекса
+void TestQueryCache() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::BANNED, { 1, 2, 8 });
+
+    const auto uncached = server.FindTopDocuments("nasty pet -rat"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 0u);
+
+    server.SetQueryCacheCapacity(2);
+    const auto first = server.FindTopDocuments("nasty pet -rat"s);
+    const auto second = server.FindTopDocuments(std::execution::par, "pet -rat nasty pet"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 1u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hits, 1u);
+    ASSERT_EQUAL(first.size(), uncached.size());
+    ASSERT_EQUAL(second.size(), uncached.size());
+    for (size_t i = 0; i < uncached.size(); ++i) {
+        ASSERT_EQUAL(first[i].id, uncached[i].id);
+        ASSERT_EQUAL(second[i].id, uncached[i].id);
+        ASSERT_EQUAL(second[i].relevance, uncached[i].relevance);
+    }
+
+    // Статус и размер выдачи входят в ключ, запросы с предикатом кеш не используют
+    server.FindTopDocuments("nasty pet -rat"s, DocumentStatus::BANNED);
+    server.FindTopDocuments("nasty pet -rat"s, DocumentStatus::ACTUAL, 1);
+    server.FindTopDocuments("nasty pet -rat"s, [](int, DocumentStatus, int) { return true; });
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 3u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hits, 1u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().size, 2u);
+
+    // Добавление документа меняет IDF всех слов, поэтому кеш сбрасывается
+    server.AddDocument(4, "nasty dog"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(server.GetQueryCacheStats().size, 0u);
+    const auto after_add = server.FindTopDocuments("nasty pet -rat"s);
+    ASSERT_EQUAL(after_add.size(), 2u);
+    ASSERT_EQUAL(after_add[0].id, 2);
+    ASSERT_EQUAL(after_add[1].id, 4);
+
+    server.RemoveDocument(4);
+    const auto after_remove = server.FindTopDocuments("nasty pet -rat"s);
+    ASSERT_EQUAL(after_remove.size(), uncached.size());
+    ASSERT_EQUAL(after_remove[0].relevance, uncached[0].relevance);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 5u);
+
+    server.SetQueryCacheCapacity(0);
+    ASSERT_EQUAL(server.GetQueryCacheStats().size, 0u);
+}
+
+// Память индекса учитывается по составляющим, тексты и слова не дублируются
+void TestMemoryUsage() {
+    SearchServer server("and with"s);
+    const auto empty_usage = server.GetMemoryUsage();
+    ASSERT_EQUAL(empty_usage.document_texts, 0u);
+    ASSERT_EQUAL(empty_usage.postings, 0u);
+
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    const auto first_usage = server.GetMemoryUsage();
+    ASSERT(first_usage.document_texts > 0);
+    ASSERT(first_usage.terms > 0);
+    ASSERT(first_usage.postings > 0);
+    ASSERT(first_usage.word_frequencies > 0);
+    ASSERT(first_usage.documents > 0);
+    ASSERT_EQUAL(first_usage.GetTotal(), first_usage.document_texts + first_usage.terms + first_usage.postings
+        + first_usage.word_frequencies + first_usage.documents);
+
+    // Тексты документов складываются в общие блоки, а повторные слова не занимают новой памяти в словаре
+    for (int id = 2; id < 100; ++id) {
+        server.AddDocument(id, "nasty rat and funny pet"s, DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto usage = server.GetMemoryUsage();
+    ASSERT_EQUAL(usage.document_texts, first_usage.document_texts);
+    ASSERT_EQUAL(usage.terms, first_usage.terms);
+    ASSERT(usage.postings > first_usage.postings);
+
+    const auto [words, status] = server.MatchDocument("rat"s, 42);
+    ASSERT_EQUAL(words.size(), 1u);
+    ASSERT_EQUAL(words[0], "rat"s);
+}
+
+// Пакетное добавление документов строит тот же индекс, что и добавление по одному
+void TestAddDocumentsBatch() {
+    std::mt19937 generator(5);
+    // Стоп-слово в текстах проверяет, что пакет отбрасывает его так же, как AddDocument
+    std::vector<std::string> words = RANDOM_TEXT_WORDS;
+    words.push_back("and"s);
+    const auto texts = MakeRandomTexts(generator, words, 3000, 8);
+    SearchServer expected_server("and"s);
+    std::vector<NewDocument> documents;
+    for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+        const DocumentStatus status = id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        expected_server.AddDocument(id * 2, texts[id], status, { id % 10, 3 });
+        documents.push_back({ id * 2, texts[id], status, { id % 10, 3 } });
+    }
+    SearchServer seq_server("and"s);
+    seq_server.AddDocuments(documents);
+    SearchServer par_server("and"s);
+    par_server.AddDocument(100'001, "cat mouse"s, DocumentStatus::ACTUAL, { 1 });
+    par_server.RemoveDocument(100'001);
+    par_server.AddDocuments(std::execution::par, documents);
+    for (const SearchServer* server : { &seq_server, &par_server }) {
+        ASSERT_EQUAL(server->GetDocumentCount(), expected_server.GetDocumentCount());
+        ASSERT_EQUAL(server->GetWordFrequencies(42).size(), expected_server.GetWordFrequencies(42).size());
+        for (const std::string& query : { "cat dog -fish"s, "mouse cow goat"s, "bird"s }) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                const auto expected = expected_server.FindTopDocuments(query, status, 20);
+                const auto result = server->FindTopDocuments(query, status, 20);
+                ASSERT_EQUAL_HINT(result.size(), expected.size(), query);
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL_HINT(result[i].id, expected[i].id, query);
+                    ASSERT_EQUAL(result[i].relevance, expected[i].relevance);
+                    ASSERT_EQUAL(result[i].rating, expected[i].rating);
+                }
+            }
+        }
+        const auto [matched_words, status] = server->MatchDocument("cat dog bird fish mouse horse cow goat"s, 84);
+        ASSERT(matched_words == std::get<0>(expected_server.MatchDocument("cat dog bird fish mouse horse cow goat"s, 84)));
+    }
+
+    // Некорректный документ в пакете не меняет индекс
+    const std::string invalid_text = "big c\x12t"s;
+    for (const std::vector<NewDocument>& invalid_documents : {
+        std::vector<NewDocument>{ { 1, "big cat", DocumentStatus::ACTUAL, {} }, { 3, invalid_text, DocumentStatus::ACTUAL, {} } },
+        std::vector<NewDocument>{ { 1, "big cat", DocumentStatus::ACTUAL, {} }, { 1, "big dog", DocumentStatus::ACTUAL, {} } },
+        std::vector<NewDocument>{ { 1, "big cat", DocumentStatus::ACTUAL, {} }, { 4, "big dog", DocumentStatus::ACTUAL, {} } },
+        }) {
+        try {
+            seq_server.AddDocuments(std::execution::par, invalid_documents);
+            ASSERT_HINT(false, "Invalid batch must be rejected"s);
+        }
+        catch (const std::invalid_argument&) {
+        }
+        ASSERT_EQUAL(seq_server.GetDocumentCount(), texts.size());
+        ASSERT(seq_server.FindTopDocuments("big"s).empty());
+    }
+}
+
+// Снимок индекса восстанавливает ту же выдачу, повреждённый файл отвергается
+void TestSnapshot() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::BANNED, { 1, 2, 8 });
+    server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, { 1, 3, 2 });
+    server.AddDocument(5, "funny cat"s, DocumentStatus::IRRELEVANT, { 5 });
+    server.RemoveDocument(4);
+
+    const std::string path = "search_server_snapshot_test.bin"s;
+    server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    ASSERT_EQUAL(loaded.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT(std::equal(loaded.begin(), loaded.end(), server.begin(), server.end()));
+    for (const std::string& query : { "funny nasty cat -rat"s, "big with hair"s, "Vladislav"s }) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::IRRELEVANT }) {
+            const auto expected = server.FindTopDocuments(query, status);
+            const auto result = loaded.FindTopDocuments(query, status);
+            ASSERT_EQUAL_HINT(result.size(), expected.size(), query);
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQUAL(result[i].id, expected[i].id);
+                ASSERT_EQUAL(result[i].relevance, expected[i].relevance);
+                ASSERT_EQUAL(result[i].rating, expected[i].rating);
+            }
+        }
+    }
+    for (const int document_id : server) {
+        ASSERT(loaded.GetWordFrequencies(document_id) == server.GetWordFrequencies(document_id));
+    }
+    const auto [words, status] = loaded.MatchDocument("nasty big hair"s, 3);
+    ASSERT_EQUAL(words.size(), 3u);
+    ASSERT(status == DocumentStatus::BANNED);
+    ASSERT(loaded.FindTopDocuments("with"s).empty());
+
+    // Повреждённый файл не загружается
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-3, std::ios::end);
+        file.put('#');
+    }
+    try {
+        SearchServer::LoadSnapshot(path);
+        ASSERT_HINT(false, "Corrupted snapshot must be rejected"s);
+    }
+    catch (const std::runtime_error&) {
+    }
+    std::remove(path.c_str());
+    try {
+        SearchServer::LoadSnapshot(path);
+        ASSERT_HINT(false, "Missing snapshot must be rejected"s);
+    }
+    catch (const std::runtime_error&) {
+    }
+}
+
+// Сжатый постинг-лист возвращает те же постинги при обходе, переходах курсора и удалениях
+void TestPostingListCompression() {
+    std::mt19937 generator(17);
+    // Все ядра распаковки восстанавливают одинаковые номера при любой ширине разности
+    for (uint32_t max_gap_bits = 0; max_gap_bits <= 20; ++max_gap_bits) {
+        // Последний вариант — ещё и один разрыв почти во весь диапазон int
+        const bool with_long_gap = max_gap_bits == 20;
+        std::vector<int> documents(POSTING_BLOCK_SIZE);
+        int document_number = std::uniform_int_distribution(0, 1000)(generator);
+        for (int& document : documents) {
+            document = document_number;
+            document_number += 1 + static_cast<int>(generator() & ((uint32_t{ 1 } << max_gap_bits) - 1));
+            if (with_long_gap && &document == &documents[60]) {
+                document_number += 1'900'000'000;
+            }
+        }
+        std::vector<uint32_t> packed;
+        const uint32_t bit_width = PackPostingBlock(documents.data(), packed);
+        ASSERT(with_long_gap ? bit_width == 31 : bit_width <= max_gap_bits + 1);
+        ASSERT_EQUAL(packed.size(), bit_width * 4);
+        for (const PostingDecodeKernel kernel : { PostingDecodeKernel::SCALAR, PostingDecodeKernel::SSE2, PostingDecodeKernel::AVX2 }) {
+            if (!IsPostingDecodeKernelSupported(kernel)) {
+                continue;
+            }
+            std::vector<int> decoded(POSTING_BLOCK_SIZE);
+            DecodePostingBlock(packed.data(), bit_width, documents[0], decoded.data(), kernel);
+            ASSERT_HINT(decoded == documents, "Kernel "s + std::to_string(static_cast<int>(kernel)));
+        }
+    }
+
+    PostingList postings;
+    std::map<int, double> expected;
+    int document_number = 0;
+    for (int i = 0; i < 1000; ++i) {
+        document_number += 1 + (i % 100 == 0 ? 100'000 : std::uniform_int_distribution(0, 20)(generator));
+        const double term_freq = std::uniform_real_distribution(0.01, 1.0)(generator);
+        postings.Add(document_number, term_freq);
+        expected[document_number] = term_freq;
+    }
+    std::vector<int> numbers;
+    for (const auto& [number, term_freq] : expected) {
+        numbers.push_back(number);
+    }
+    std::set<int> removed;
+    for (int i = 0; i < 200; ++i) {
+        const int number = numbers[std::uniform_int_distribution<size_t>(0, numbers.size() - 1)(generator)];
+        removed.insert(number);
+        expected.erase(number);
+    }
+    postings.RemoveIf([&removed](int number) {
+        return removed.count(number) > 0;
+        });
+    // Повторное добавление прибавляет частоту, вставка в середину пересобирает лист
+    postings.Add(numbers[3], 0.5);
+    expected[numbers[3]] += 0.5;
+    postings.Add(numbers[5] + 1, 0.25);
+    expected[numbers[5] + 1] += 0.25;
+    ASSERT_EQUAL(postings.size(), expected.size());
+
+    const auto check_range = [&](int first_document, int last_document) {
+        auto it = expected.lower_bound(first_document);
+        postings.ForEachInRange(first_document, last_document, [&](int number, double term_freq) {
+            ASSERT(it != expected.end());
+            ASSERT_EQUAL(number, it->first);
+            ASSERT(std::abs(term_freq - it->second) < 1e-7);
+            ++it;
+        });
+        ASSERT(it == expected.lower_bound(last_document));
+    };
+    check_range(0, std::numeric_limits<int>::max());
+    check_range(numbers[150], numbers[700]);
+    check_range(numbers[999] + 1, std::numeric_limits<int>::max());
+
+    double max_term_freq = 0.0;
+    for (const auto& [number, term_freq] : expected) {
+        max_term_freq = std::max(max_term_freq, term_freq);
+    }
+    ASSERT(postings.GetMaxTermFreq() >= max_term_freq - 1e-7);
+
+    // Курсор с переходами через целые блоки
+    PostingList::Cursor cursor(postings);
+    auto it = expected.begin();
+    for (int step = 0; !cursor.IsEnd(); ++step) {
+        ASSERT(it != expected.end());
+        ASSERT_EQUAL(cursor.GetDocumentNumber(), it->first);
+        if (step % 3 == 0) {
+            const int target = it->first + std::uniform_int_distribution(1, 3000)(generator);
+            cursor.Advance(target);
+            it = expected.lower_bound(target);
+        }
+        else {
+            cursor.Next();
+            ++it;
+        }
+    }
+    ASSERT(it == expected.end());
+
+    postings.RemoveIf([](int) {
+        return true;
+        });
+    ASSERT(postings.empty());
+    ASSERT(PostingList::Cursor(postings).IsEnd());
+}
+
+// Токенизатор: ядра совпадают с разбиением по find, управляющие символы отвергаются
+void TestTokenizer() {
+    const std::vector<TokenizerKernel> kernels = { TokenizerKernel::SCALAR, TokenizerKernel::SSE2, TokenizerKernel::AVX2 };
+    const auto split_reference = [](std::string_view text) {
+        std::vector<std::string_view> words;
+        while (true) {
+            const auto space = text.find(' ');
+            words.push_back(text.substr(0, space));
+            if (space == text.npos) {
+                break;
+            }
+            text.remove_prefix(space + 1);
+        }
+        return words;
+    };
+
+    // Длины текстов пересекают границы 16- и 32-байтных блоков, пробелы и управляющие символы стоят в разных позициях
+    std::mt19937 generator;
+    std::vector<std::string_view> words;
+    for (int length = 0; length < 100; ++length) {
+        for (int attempt = 0; attempt < 20; ++attempt) {
+            std::string text(length, 'a');
+            bool has_control = false;
+            for (char& c : text) {
+                const int kind = std::uniform_int_distribution(0, 9)(generator);
+                if (kind < 3) {
+                    c = ' ';
+                }
+                else if (kind == 3 && attempt % 4 == 0) {
+                    c = static_cast<char>(std::uniform_int_distribution(0, 31)(generator));
+                    has_control = true;
+                }
+                else if (kind == 4) {
+                    c = static_cast<char>(std::uniform_int_distribution(128, 255)(generator));
+                }
+            }
+            const auto expected = split_reference(text);
+            for (const TokenizerKernel kernel : kernels) {
+                if (!IsTokenizerKernelSupported(kernel)) {
+                    continue;
+                }
+                ASSERT_EQUAL(SplitIntoWords(text, words, kernel), !has_control);
+                ASSERT(words == expected);
+            }
+        }
+    }
+
+    // Буфер очищается и переиспользуется
+    ASSERT(SplitIntoWords("cat  dog", words));
+    ASSERT((words == std::vector<std::string_view>{ "cat", "", "dog" }));
+    ASSERT(SplitIntoWords("", words));
+    ASSERT((words == std::vector<std::string_view>{ "" }));
+    ASSERT(!SplitIntoWords("cat d\x12og", words));
+
+    SearchServer server("in the"s);
+    server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(server.GetWordFrequencies(1).size(), 2u);
+    try {
+        server.AddDocument(2, "dog in the c\x12ity"s, DocumentStatus::ACTUAL, { 1 });
+        ASSERT_HINT(false, "Control characters in a document must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    try {
+        server.FindTopDocuments("cat -c\x12ity"s);
+        ASSERT_HINT(false, "Control characters in a query must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    try {
+        SearchServer invalid_server("in t\x12he"s);
+        ASSERT_HINT(false, "Control characters in stop words must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    ASSERT_EQUAL(server.FindTopDocuments("cat -dog"s).size(), 1u);
+}
+
+// Поиск через контекст запроса совпадает с обычным и после прогрева не выделяет память
+void TestQueryContextAllocations() {
+    std::mt19937 generator;
+    std::vector<std::string> words;
+    for (int i = 0; i < 200; ++i) {
+        words.push_back("w"s + std::to_string(i));
+    }
+    SearchServer server("w0 w1"s);
+    for (int id = 0; id < 3000; ++id) {
+        std::string text;
+        for (int i = 0; i < 12; ++i) {
+            text += words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] + " "s;
+        }
+        text += "w"s + std::to_string(id % 7);
+        server.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), { id % 10 });
+    }
+    std::vector<std::string> queries;
+    for (int i = 0; i < 50; ++i) {
+        std::string query;
+        for (int j = 0; j < 6; ++j) {
+            query += (j == 5 ? "-w"s : "w"s) + std::to_string(std::uniform_int_distribution(0, 220)(generator)) + " "s;
+        }
+        queries.push_back(query + "w3 w3"s);
+    }
+    const auto same_documents = [](const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& l, const Document& r) {
+            return l.id == r.id && l.relevance == r.relevance && l.rating == r.rating;
+        });
+    };
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 0;
+    };
+
+    for (const auto mode : { SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME, SearchServer::EvaluationMode::TERM_AT_A_TIME }) {
+        server.SetEvaluationMode(mode);
+        SearchServer::QueryContext context;
+        for (const std::string& query : queries) {
+            ASSERT(same_documents(server.FindTopDocuments(context, query), server.FindTopDocuments(query)));
+            ASSERT(same_documents(server.FindTopDocuments(context, query, DocumentStatus::BANNED, 10), server.FindTopDocuments(query, DocumentStatus::BANNED, 10)));
+            ASSERT(same_documents(server.FindTopDocuments(context, query, is_even), server.FindTopDocuments(query, is_even)));
+        }
+
+        // После прогрева повторные запросы не выделяют память. Без счётчика проверка прошла бы молча,
+        // поэтому тест требует сборки с SEARCH_SERVER_COUNT_ALLOCATIONS
+        ASSERT_HINT(ALLOCATION_COUNTING_ENABLED, "Build the tests with -DSEARCH_SERVER_COUNT_ALLOCATIONS"s);
+        const size_t allocations_before = GetThreadAllocationCount();
+        size_t result_count = 0;
+        for (const std::string& query : queries) {
+            result_count += server.FindTopDocuments(context, query).size();
+            result_count += server.FindTopDocuments(context, query, DocumentStatus::BANNED, 10).size();
+            result_count += server.FindTopDocuments(context, query, is_even).size();
+        }
+        const size_t allocations = GetThreadAllocationCount() - allocations_before;
+        ASSERT_EQUAL(allocations, 0u);
+        ASSERT(result_count > 0);
+    }
+
+    SearchServer::QueryContext context;
+    try {
+        server.FindTopDocuments(context, "w3 --w4"s);
+        ASSERT_HINT(false, "Invalid query must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    ASSERT(same_documents(server.FindTopDocuments(context, "w3"s), server.FindTopDocuments("w3"s)));
+}
+
+// IDF поддерживается при добавлении, удалении и загрузке снимка
+void TestIncrementalInverseDocumentFreq() {
+    // Релеванцию единственного слова запроса можно пересчитать вручную: tf * log(N / df)
+    const auto check_relevance = [](const SearchServer& server, std::string_view word, int document_id,
+        double term_freq, size_t document_freq) {
+        const auto documents = server.FindTopDocuments(word, [document_id](int id, DocumentStatus, int) {
+            return id == document_id;
+            });
+        ASSERT_EQUAL(documents.size(), 1u);
+        const double expected = term_freq * std::log(server.GetDocumentCount() * 1.0 / document_freq);
+        ASSERT(std::abs(documents[0].relevance - expected) < TopDocuments::RELEVANCE_EPSILON);
+    };
+
+    SearchServer server(""s);
+    server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "cat bird"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(3, "fish"s, DocumentStatus::ACTUAL, { 1 });
+    check_relevance(server, "dog", 1, 0.5, 1);
+    check_relevance(server, "cat", 2, 0.5, 2);
+
+    // Добавление документов меняет и N, и df
+    server.AddDocuments({ { 4, "cat cat fish", DocumentStatus::ACTUAL, { 1 } }, { 5, "dog", DocumentStatus::ACTUAL, { 1 } } });
+    check_relevance(server, "cat", 4, 2.0 / 3, 3);
+    check_relevance(server, "dog", 5, 1.0, 2);
+    check_relevance(server, "fish", 3, 1.0, 2);
+
+    // Удаление уменьшает df слов документа и N
+    server.RemoveDocument(1);
+    check_relevance(server, "cat", 2, 0.5, 2);
+    check_relevance(server, "dog", 5, 1.0, 1);
+    server.RemoveDocument(std::execution::par, 4);
+    check_relevance(server, "cat", 2, 0.5, 1);
+    check_relevance(server, "fish", 3, 1.0, 1);
+
+    // Слово во всех документах не влияет на релевантность
+    server.AddDocument(6, "bird"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(7, "cat bird dog fish"s, DocumentStatus::ACTUAL, { 1 });
+    const auto documents = server.FindTopDocuments("-cat bird"s);
+    ASSERT_EQUAL(documents.size(), 1u);
+    ASSERT_EQUAL(documents[0].id, 6);
+    ASSERT(std::abs(documents[0].relevance - std::log(5.0 / 3)) < TopDocuments::RELEVANCE_EPSILON);
+
+    const std::string path = "test_idf_snapshot.bin"s;
+    server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    std::remove(path.c_str());
+    check_relevance(loaded, "cat", 7, 0.25, 2);
+    check_relevance(loaded, "bird", 6, 1.0, 3);
+}
+
+// Отложенное удаление: документы сразу исчезают из выдачи, постинги освобождаются при сжатии
+void TestRemoveDocumentsDeferred() {
+    const auto add_documents = [](SearchServer& server) {
+        std::vector<NewDocument> documents;
+        static const std::vector<std::string> texts = {
+            "cat and dog"s, "cat city"s, "dog park"s, "bird city"s, "cat bird"s, "lonely fox"s,
+        };
+        for (int i = 0; i < 60; ++i) {
+            documents.push_back({ i, texts[i % texts.size()], static_cast<DocumentStatus>(i % 2), { i } });
+        }
+        server.AddDocuments(documents);
+    };
+    const auto ids = [](const std::vector<Document>& documents) {
+        std::set<int> result;
+        for (const Document& document : documents) {
+            result.insert(document.id);
+        }
+        return result;
+    };
+
+    SearchServer server("and"s);
+    add_documents(server);
+    // Небольшое удаление не запускает сжатие, но документы сразу пропадают из выдачи
+    std::vector<int> removed;
+    for (int id = 0; id < 60; id += 6) {
+        removed.push_back(id);
+    }
+    removed.push_back(1000);
+    const size_t postings_before = server.GetMemoryUsage().postings;
+    server.RemoveDocuments(removed);
+    ASSERT_EQUAL(server.GetDocumentCount(), 50u);
+    ASSERT_EQUAL(server.GetMemoryUsage().postings, postings_before);
+
+    SearchServer expected("and"s);
+    for (int i = 0; i < 60; ++i) {
+        if (i % 6 != 0) {
+            static const std::vector<std::string> texts = {
+                "cat and dog"s, "cat city"s, "dog park"s, "bird city"s, "cat bird"s, "lonely fox"s,
+            };
+            expected.AddDocument(i, texts[i % texts.size()], static_cast<DocumentStatus>(i % 2), { i });
+        }
+    }
+    for (const std::string& query : { "cat"s, "cat dog -park"s, "city bird"s, "dog"s }) {
+        for (const auto mode : { SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME, SearchServer::EvaluationMode::TERM_AT_A_TIME }) {
+            server.SetEvaluationMode(mode);
+            const auto documents = server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 100);
+            const auto expected_documents = expected.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 100);
+            ASSERT_EQUAL(documents.size(), expected_documents.size());
+            for (size_t i = 0; i < documents.size(); ++i) {
+                ASSERT_EQUAL(documents[i].id, expected_documents[i].id);
+                ASSERT(std::abs(documents[i].relevance - expected_documents[i].relevance) < TopDocuments::RELEVANCE_EPSILON);
+            }
+            ASSERT(ids(server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 100))
+                == ids(expected.FindTopDocuments(query, DocumentStatus::ACTUAL, 100)));
+        }
+        ASSERT(ids(server.FindTopDocumentsBatch(std::execution::seq, { query }, DocumentStatus::BANNED, 100)[0])
+            == ids(expected.FindTopDocuments(query, DocumentStatus::BANNED, 100)));
+    }
+
+    // Слово, оставшееся только в удалённых документах, больше не находится
+    ASSERT(server.FindTopDocuments("lonely fox"s).empty());
+    const std::string path = "test_remove_snapshot.bin"s;
+    server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    std::remove(path.c_str());
+    ASSERT_EQUAL(loaded.GetDocumentCount(), 50u);
+    ASSERT(ids(loaded.FindTopDocuments("cat"s, DocumentStatus::BANNED, 100)) == ids(expected.FindTopDocuments("cat"s, DocumentStatus::BANNED, 100)));
+
+    // Явное сжатие освобождает постинги удалённых документов
+    server.CompactPostings();
+    ASSERT(server.GetMemoryUsage().postings < postings_before);
+    ASSERT(ids(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100)) == ids(expected.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100)));
+
+    // Освобождённое слово снова находится после повторного добавления
+    server.AddDocument(100, "lonely fox"s, DocumentStatus::ACTUAL, { 1 });
+    const auto foxes = server.FindTopDocuments("fox"s);
+    ASSERT_EQUAL(foxes.size(), 1u);
+    ASSERT_EQUAL(foxes[0].id, 100);
+
+    // Удаление больше половины постингов сжимает списки автоматически
+    SearchServer expiring("and"s);
+    add_documents(expiring);
+    const size_t full_postings = expiring.GetMemoryUsage().postings;
+    std::vector<int> expired(40);
+    std::iota(expired.begin(), expired.end(), 0);
+    expiring.RemoveDocuments(std::execution::par, expired);
+    ASSERT_EQUAL(expiring.GetDocumentCount(), 20u);
+    ASSERT(expiring.GetMemoryUsage().postings < full_postings);
+    for (int id = 40; id < 60; ++id) {
+        expiring.RemoveDocument(std::execution::par, id);
+    }
+    ASSERT_EQUAL(expiring.GetDocumentCount(), 0u);
+    ASSERT(expiring.FindTopDocuments("cat"s).empty());
+}
+
+// Одновременные чтения и записи: читатели видят согласованные поколения, копии совпадают
+void TestConcurrentSearchServer() {
+    ConcurrentSearchServer server("and"s);
+    server.AddDocument(0, "common seed"s, DocumentStatus::ACTUAL, { 1 });
+    try {
+        server.AddDocument(0, "common again"s, DocumentStatus::ACTUAL, { 1 });
+        ASSERT_HINT(false, "Duplicate id must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 1u);
+    ASSERT_EQUAL(server.GetGeneration(), 1u);
+
+    // Писатели добавляют и удаляют документы, читатели в каждом поколении видят согласованный индекс:
+    // запрос по общему слову находит ровно все документы поколения
+    constexpr int WRITER_COUNT = 2;
+    constexpr int READER_COUNT = 4;
+    constexpr int DOCUMENTS_PER_WRITER = 300;
+    std::atomic<bool> writers_done = false;
+    std::atomic<int> inconsistent_reads = 0;
+    std::atomic<int> reads = 0;
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < WRITER_COUNT; ++writer) {
+        threads.emplace_back([&server, writer] {
+            for (int i = 1; i <= DOCUMENTS_PER_WRITER; ++i) {
+                const int document_id = writer * 100'000 + i;
+                server.AddDocument(document_id, "common w"s + std::to_string(i % 10), DocumentStatus::ACTUAL, { i });
+                if (i % 3 == 0) {
+                    server.RemoveDocument(document_id - 1);
+                }
+                if (i % 50 == 0) {
+                    server.AddDocuments({ { writer * 100'000 + 50'000 + i, "common batch", DocumentStatus::ACTUAL, { 1 } } });
+                }
+            }
+        });
+    }
+    for (int reader = 0; reader < READER_COUNT; ++reader) {
+        threads.emplace_back([&] {
+            uint64_t last_generation = 0;
+            // Хотя бы одно чтение, даже если писатели закончили раньше, чем поток запустился
+            do {
+                const uint64_t generation = server.GetGeneration();
+                if (generation < last_generation) {
+                    ++inconsistent_reads;
+                }
+                last_generation = generation;
+                const bool consistent = server.Read([](const SearchServer& index) {
+                    const auto documents = index.FindTopDocuments("common"s, [](int, DocumentStatus, int) {
+                        return true;
+                        }, 1'000'000);
+                    return documents.size() == index.GetDocumentCount();
+                });
+                if (!consistent) {
+                    ++inconsistent_reads;
+                }
+                ++reads;
+            } while (!writers_done.load());
+        });
+    }
+    for (int writer = 0; writer < WRITER_COUNT; ++writer) {
+        threads[writer].join();
+    }
+    writers_done = true;
+    for (size_t i = WRITER_COUNT; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    ASSERT_EQUAL(inconsistent_reads.load(), 0);
+    ASSERT(reads.load() > 0);
+
+    const size_t expected_count = 1 + WRITER_COUNT * (DOCUMENTS_PER_WRITER - DOCUMENTS_PER_WRITER / 3 + DOCUMENTS_PER_WRITER / 50);
+    ASSERT_EQUAL(server.GetDocumentCount(), expected_count);
+
+    // Обе копии совпадают: пустая запись переключает поколение
+    const auto before = server.FindTopDocuments("common w3 batch"s, DocumentStatus::ACTUAL, 50);
+    server.Write([](SearchServer&) {});
+    const auto after = server.FindTopDocuments("common w3 batch"s, DocumentStatus::ACTUAL, 50);
+    ASSERT_EQUAL(before.size(), after.size());
+    for (size_t i = 0; i < before.size(); ++i) {
+        ASSERT_EQUAL(before[i].id, after[i].id);
+        ASSERT_EQUAL(before[i].relevance, after[i].relevance);
+    }
+}
+
+// Тест проверяет, что сегментированный индекс с фоновыми слияниями находит то же, что и несегментированный
+void TestSegmentedIndex() {
+    static const std::vector<std::string> texts = {
+        "cat and dog"s, "cat city"s, "dog park"s, "bird city"s, "cat bird"s, "fox in the city"s, "white cat"s,
+    };
+    // NewDocument хранит string_view, поэтому тексты живут до конца теста
+    std::vector<std::string> all_texts;
+    for (int id = 0; id < 200; ++id) {
+        all_texts.push_back(texts[id % texts.size()] + (id % 5 == 0 ? " rare"s : ""s));
+    }
+    const auto text = [&all_texts](int id) -> const std::string& {
+        return all_texts[id];
+    };
+    const auto same_results = [](const SearchServer& server, const SearchServer& expected, const std::string& query) {
+        const auto documents = server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 1000);
+        const auto expected_documents = expected.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 1000);
+        ASSERT_EQUAL(documents.size(), expected_documents.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL(documents[i].id, expected_documents[i].id);
+            ASSERT(std::abs(documents[i].relevance - expected_documents[i].relevance) < TopDocuments::RELEVANCE_EPSILON);
+        }
+    };
+
+    SearchServer server("and"s);
+    for (const auto& [document_count, merge_factor] : { std::pair<size_t, size_t>{ 0, 4 }, { 8, 1 } }) {
+        try {
+            server.SetSegmentPolicy(document_count, merge_factor);
+            ASSERT_HINT(false, "Invalid segment policy must be rejected"s);
+        }
+        catch (const std::invalid_argument&) {
+        }
+    }
+
+    // Маленький сегмент и слияние по два: индекс из многих сегментов сравнивается с несегментированным
+    server.SetSegmentPolicy(8, 2);
+    SearchServer expected("and"s);
+    int next_id = 0;
+    for (int round = 0; round < 12; ++round) {
+        std::vector<NewDocument> documents;
+        for (int i = 0; i < 13; ++i, ++next_id) {
+            if (round % 2 == 0) {
+                server.AddDocument(next_id, text(next_id), static_cast<DocumentStatus>(next_id % 2), { next_id });
+            }
+            else {
+                documents.push_back({ next_id, text(next_id), static_cast<DocumentStatus>(next_id % 2), { next_id } });
+            }
+            expected.AddDocument(next_id, text(next_id), static_cast<DocumentStatus>(next_id % 2), { next_id });
+        }
+        server.AddDocuments(std::execution::par, documents);
+        std::vector<int> removed;
+        for (int id = round; id < next_id; id += 9) {
+            removed.push_back(id);
+        }
+        server.RemoveDocuments(removed);
+        expected.RemoveDocuments(removed);
+    }
+    ASSERT(server.GetSegmentCount() > 1);
+    ASSERT_EQUAL(server.GetDocumentCount(), expected.GetDocumentCount());
+
+    const std::vector<std::string> queries = { "cat"s, "cat dog -park"s, "city bird rare"s, "rare -cat"s, "white fox"s };
+    const auto check_all = [&]() {
+        for (const std::string& query : queries) {
+            for (const auto mode : { SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME, SearchServer::EvaluationMode::TERM_AT_A_TIME }) {
+                server.SetEvaluationMode(mode);
+                same_results(server, expected, query);
+                const auto documents = server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 1000);
+                const auto expected_documents = expected.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+                ASSERT_EQUAL(documents.size(), expected_documents.size());
+            }
+            const auto batch = server.FindTopDocumentsBatch(std::execution::seq, { query }, DocumentStatus::BANNED, 1000)[0];
+            const auto expected_documents = expected.FindTopDocuments(query, DocumentStatus::BANNED, 1000);
+            ASSERT_EQUAL(batch.size(), expected_documents.size());
+            for (size_t i = 0; i < batch.size(); ++i) {
+                ASSERT_EQUAL(batch[i].id, expected_documents[i].id);
+            }
+        }
+    };
+    check_all();
+
+    // Фоновые слияния уменьшают число сегментов, результаты не меняются
+    const size_t segments_before = server.GetSegmentCount();
+    server.WaitForMerges();
+    server.AddDocument(next_id, text(next_id), DocumentStatus::ACTUAL, { 1 });
+    expected.AddDocument(next_id, text(next_id), DocumentStatus::ACTUAL, { 1 });
+    ++next_id;
+    server.WaitForMerges();
+    ASSERT(server.GetSegmentCount() <= segments_before);
+    ASSERT(server.GetSegmentCount() < static_cast<size_t>(next_id) / 8);
+    check_all();
+
+    // Сжатие переписывает сегменты с удалёнными документами
+    std::vector<int> removed;
+    for (int id = 3; id < next_id; id += 10) {
+        removed.push_back(id);
+    }
+    server.WaitForMerges();
+    server.RemoveDocuments(removed);
+    expected.RemoveDocuments(removed);
+    const size_t postings_before = server.GetMemoryUsage().postings;
+    server.CompactPostings();
+    ASSERT(server.GetMemoryUsage().postings < postings_before);
+    check_all();
+
+    // Загруженный снимок — один неизменяемый сегмент, новые документы идут в изменяемый
+    const std::string path = "test_segments_snapshot.bin"s;
+    server.SaveSnapshot(path);
+    SearchServer loaded = SearchServer::LoadSnapshot(path);
+    std::remove(path.c_str());
+    ASSERT_EQUAL(loaded.GetSegmentCount(), 1u);
+    loaded.AddDocument(next_id, "rare white fox"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(loaded.GetSegmentCount(), 2u);
+    ASSERT_EQUAL(loaded.FindTopDocuments("rare fox"s, DocumentStatus::ACTUAL, 1000).size(),
+        expected.FindTopDocuments("rare fox"s, DocumentStatus::ACTUAL, 1000).size() + 1);
+}
+
+// Тест проверяет частоты слов документа из компактного прямого индекса
+void TestWordFrequenciesView() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat and white dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocuments({ { 2, "black cat"s, DocumentStatus::ACTUAL, { 2 } }, { 3, "dog dog parrot"s, DocumentStatus::BANNED, { 3 } } });
+
+    const WordFrequencies words = server.GetWordFrequencies(1);
+    ASSERT_EQUAL(words.size(), 3u);
+    ASSERT_EQUAL(words.count("white"s), 1u);
+    ASSERT_EQUAL(words.count("and"s), 0u);
+    ASSERT_EQUAL(words.count("parrot"s), 0u);
+    ASSERT(std::abs(words.at("white"s) - 0.5) < 1e-6);
+    try {
+        words.at("parrot"s);
+        ASSERT_HINT(false, "Missing word must throw"s);
+    }
+    catch (const std::out_of_range&) {
+    }
+    // Слова перечисляются в порядке их номеров в словаре: порядке первого появления
+    std::vector<std::string> listed;
+    for (const auto& [word, term_freq] : words) {
+        listed.emplace_back(word);
+    }
+    ASSERT(listed == std::vector<std::string>({ "cat"s, "dog"s, "white"s }));
+    ASSERT(server.GetWordFrequencies(42).empty());
+    ASSERT_EQUAL(server.GetWordFrequencies(42).count("cat"s), 0u);
+    ASSERT(std::abs(server.GetWordFrequencies(3).at("dog"s) - 2.0 / 3) < 1e-6);
+    // Представление действительно до изменения сервера, поэтому пары копируются
+    const std::vector<std::pair<std::string_view, double>> saved_words(words.begin(), words.end());
+
+    // Сжатие прямого индекса при удалениях не меняет слова оставшихся документов
+    SearchServer expected("and"s);
+    for (int id = 0; id < 50; ++id) {
+        const std::string text = "word"s + std::to_string(id) + " shared "s + std::to_string(id % 7);
+        server.AddDocument(100 + id, text, DocumentStatus::ACTUAL, { 1 });
+        expected.AddDocument(100 + id, text, DocumentStatus::ACTUAL, { 1 });
+    }
+    const size_t memory_before = server.GetMemoryUsage().word_frequencies;
+    for (int id = 0; id < 40; ++id) {
+        server.RemoveDocument(100 + id);
+    }
+    ASSERT(server.GetMemoryUsage().word_frequencies < memory_before);
+    ASSERT(server.GetWordFrequencies(100).empty());
+    for (int id = 40; id < 50; ++id) {
+        ASSERT(server.GetWordFrequencies(100 + id) == expected.GetWordFrequencies(100 + id));
+    }
+    const WordFrequencies current_words = server.GetWordFrequencies(1);
+    ASSERT(std::equal(current_words.begin(), current_words.end(), saved_words.begin(), saved_words.end()));
+    const auto [matched, status] = server.MatchDocument("white dog -parrot"s, 1);
+    ASSERT_EQUAL(matched.size(), 2u);
+}
+
+// Тест проверяет, что пакетное сопоставление запроса совпадает с MatchDocument для каждого документа
+void TestMatchDocuments() {
+    SearchServer server("and in"s);
+    server.SetSegmentPolicy(16, 2);
+    static const std::vector<std::string> texts = {
+        "cat and dog"s, "fluffy cat"s, "dog in the park"s, "bird city"s, "cat bird"s, "white fluffy dog"s, "black cat"s,
+    };
+    for (int id = 0; id < 300; ++id) {
+        server.AddDocument(id * 3, texts[id % texts.size()], static_cast<DocumentStatus>(id % 4), { id });
+    }
+    std::vector<int> removed;
+    for (int id = 0; id < 300; id += 11) {
+        removed.push_back(id * 3);
+    }
+    server.RemoveDocuments(removed);
+
+    // Произвольный порядок и повторы id; результат совпадает с поштучным MatchDocument
+    std::vector<int> document_ids(server.begin(), server.end());
+    std::reverse(document_ids.begin(), document_ids.end());
+    document_ids.push_back(document_ids.front());
+    for (const std::string& query : { "cat dog"s, "fluffy -dog cat"s, "park bird -city"s, "cat cat in"s, "-cat"s, "lion"s }) {
+        const auto results = server.MatchDocuments(query, document_ids);
+        const auto par_results = server.MatchDocuments(std::execution::par, query, document_ids);
+        ASSERT_EQUAL(results.size(), document_ids.size());
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const auto [words, status] = server.MatchDocument(query, document_ids[i]);
+            ASSERT(std::get<0>(results[i]) == words);
+            ASSERT(std::get<1>(results[i]) == status);
+            ASSERT(std::get<0>(par_results[i]) == words);
+            ASSERT(std::get<1>(par_results[i]) == status);
+        }
+    }
+    ASSERT(server.MatchDocuments("cat"s, {}).empty());
+
+    try {
+        server.MatchDocuments("cat"s, { 3, removed[1] });
+        ASSERT_HINT(false, "Removed document must not be matched"s);
+    }
+    catch (const std::out_of_range&) {
+    }
+    try {
+        server.MatchDocuments("cat --dog"s, { 3 });
+        ASSERT_HINT(false, "Invalid query must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+}
+
+// Тест проверяет, что фильтр по статусу через маски даёт те же результаты, что и предикат
+void TestStatusPushdown() {
+    SearchServer server("and in"s);
+    server.SetSegmentPolicy(32, 2);
+    static const std::vector<std::string> texts = {
+        "cat and dog"s, "fluffy cat"s, "dog in the park"s, "bird city"s, "cat bird"s, "white fluffy dog"s, "black cat"s,
+    };
+    for (int id = 0; id < 500; ++id) {
+        // Редкий статус BANNED проверяет прыжки курсоров через длинные участки чужих документов
+        const DocumentStatus status = id % 50 == 7 ? DocumentStatus::BANNED
+            : id % 3 == 0 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+        server.AddDocument(id, texts[id % texts.size()], status, { id % 13 });
+    }
+    std::vector<int> removed;
+    for (int id = 0; id < 500; id += 17) {
+        removed.push_back(id);
+    }
+    removed.push_back(57);
+    server.RemoveDocuments(removed);
+
+    const auto same_documents = [](const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& l, const Document& r) {
+            return l.id == r.id && std::abs(l.relevance - r.relevance) < 1e-9 && l.rating == r.rating;
+        });
+    };
+    const std::vector<std::string> queries = { "cat dog"s, "fluffy -dog cat"s, "park bird -city"s, "white black cat"s };
+    for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED,
+        DocumentStatus::REMOVED }) {
+        const auto has_status = [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+        };
+        const auto batch_results = server.FindTopDocumentsBatch(std::execution::seq, queries, status, 20);
+        for (const auto mode : { SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME, SearchServer::EvaluationMode::TERM_AT_A_TIME }) {
+            server.SetEvaluationMode(mode);
+            SearchServer::QueryContext context;
+            for (size_t i = 0; i < queries.size(); ++i) {
+                const auto expected = server.FindTopDocuments(queries[i], has_status, 20);
+                ASSERT(same_documents(server.FindTopDocuments(queries[i], status, 20), expected));
+                ASSERT(same_documents(server.FindTopDocuments(std::execution::par, queries[i], status, 20), expected));
+                ASSERT(same_documents(server.FindTopDocuments(context, queries[i], status, 20), expected));
+                ASSERT(same_documents(batch_results[i], expected));
+                for (const Document& document : expected) {
+                    ASSERT(std::find(removed.begin(), removed.end(), document.id) == removed.end());
+                }
+            }
+        }
+    }
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::BANNED, 20).size(), 4u);
+
+    try {
+        server.FindTopDocuments("cat"s, static_cast<DocumentStatus>(7));
+        ASSERT_HINT(false, "Invalid status must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    try {
+        server.AddDocument(1000, "cat"s, static_cast<DocumentStatus>(-1), { 1 });
+        ASSERT_HINT(false, "Invalid status must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 500 - static_cast<int>(removed.size()));
+}
+
+// Тест проверяет, что рейтинг и статус из столбцов метаданных совпадают с заданными при добавлении
+void TestDocumentMetadataColumns() {
+    SearchServer server("and"s);
+    server.SetSegmentPolicy(16, 2);
+    server.AddDocument(100, "cat and dog"s, DocumentStatus::BANNED, { 4, 6 });
+    std::vector<NewDocument> documents;
+    std::vector<std::string> texts;
+    for (int id = 0; id < 60; ++id) {
+        texts.push_back(id % 2 == 0 ? "fluffy cat"s : "white dog"s);
+    }
+    for (int id = 0; id < 60; ++id) {
+        documents.push_back({ id * 7, texts[id], static_cast<DocumentStatus>(id % 3), { id, id + 2 } });
+    }
+    server.AddDocuments(documents);
+    server.AddDocument(5, "black cat"s, DocumentStatus::IRRELEVANT, { -3 });
+    server.RemoveDocuments({ 0, 14, 100 });
+
+    // Предикат получает рейтинг и статус своего документа на всех путях вычисления
+    const auto check_metadata = [](const SearchServer& server) {
+        const auto predicate = [](int document_id, DocumentStatus status, int rating) {
+            if (document_id == 5) {
+                return status == DocumentStatus::IRRELEVANT && rating == -3;
+            }
+            const int id = document_id / 7;
+            return status == static_cast<DocumentStatus>(id % 3) && rating == id + 1;
+        };
+        for (const std::string& query : { "cat"s, "dog"s, "cat dog -white"s }) {
+            const auto all = server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 100);
+            ASSERT_EQUAL(server.FindTopDocuments(query, predicate, 100).size(), all.size());
+            ASSERT_EQUAL(server.FindTopDocuments(std::execution::par, query, predicate, 100).size(), all.size());
+            for (const Document& document : all) {
+                ASSERT(document.id != 0 && document.id != 14 && document.id != 100);
+                ASSERT_EQUAL(document.rating, document.id == 5 ? -3 : document.id / 7 + 1);
+                const auto [words, status] = server.MatchDocument(query, document.id);
+                ASSERT(status == (document.id == 5 ? DocumentStatus::IRRELEVANT : static_cast<DocumentStatus>(document.id / 7 % 3)));
+            }
+        }
+    };
+    for (const auto mode : { SearchServer::EvaluationMode::DOCUMENT_AT_A_TIME, SearchServer::EvaluationMode::TERM_AT_A_TIME }) {
+        server.SetEvaluationMode(mode);
+        check_metadata(server);
+    }
+
+    const std::string path = "search_server_metadata_test.bin"s;
+    server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    std::remove(path.c_str());
+    check_metadata(loaded);
+    ASSERT_EQUAL(loaded.FindTopDocuments("cat dog"s, DocumentStatus::IRRELEVANT, 100).size(),
+        server.FindTopDocuments("cat dog"s, DocumentStatus::IRRELEVANT, 100).size());
+}
+
+// Тест проверяет постраничный поиск по смещению и по продолжению
+void TestPagedSearch() {
+    SearchServer server("and"s);
+    static const std::vector<std::string> texts = {
+        "cat and dog"s, "fluffy cat"s, "dog in the park"s, "cat bird"s, "white fluffy dog"s, "black cat cat"s,
+    };
+    for (int id = 0; id < 200; ++id) {
+        server.AddDocument(id, texts[id % texts.size()], id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+            { id % 17 });
+    }
+    const std::string query = "fluffy cat -park"s;
+    const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+    ASSERT(expected.size() > 40);
+    const auto same_documents = [](auto first, auto last, auto expected_first, auto expected_last) {
+        return std::equal(first, last, expected_first, expected_last, [](const Document& l, const Document& r) {
+            return l.id == r.id && l.relevance == r.relevance && l.rating == r.rating;
+        });
+    };
+
+    // Листание продолжениями даёт ту же выдачу, что и один большой отбор
+    std::vector<Document> paged;
+    SearchServer::SearchPage page = server.FindTopDocumentsPage(query, DocumentStatus::ACTUAL, 0, 7);
+    for (;;) {
+        paged.insert(paged.end(), page.documents.begin(), page.documents.end());
+        if (page.next.IsEnd()) {
+            break;
+        }
+        page = server.FindNextPage(page.next, 7);
+    }
+    ASSERT(same_documents(paged.begin(), paged.end(), expected.begin(), expected.end()));
+
+    // Страница по смещению совпадает с участком полной выдачи и делится через Paginate
+    for (const auto& [offset, limit] : std::vector<std::pair<size_t, size_t>>{ { 0, 5 }, { 20, 10 }, { 35, 100 }, { 1000, 3 } }) {
+        const auto seq_page = server.FindTopDocumentsPage(query, DocumentStatus::ACTUAL, offset, limit);
+        const auto par_page = server.FindTopDocumentsPage(std::execution::par, query, DocumentStatus::ACTUAL, offset, limit);
+        const auto first = expected.begin() + std::min(offset, expected.size());
+        const auto last = expected.begin() + std::min(offset + limit, expected.size());
+        ASSERT(same_documents(seq_page.documents.begin(), seq_page.documents.end(), first, last));
+        ASSERT(same_documents(par_page.documents.begin(), par_page.documents.end(), first, last));
+        ASSERT_EQUAL(seq_page.next.GetOffset(), offset + limit);
+        size_t paginated = 0;
+        for (const auto& subpage : Paginate(seq_page.documents, 3)) {
+            ASSERT(subpage.size() <= 3u);
+            paginated += subpage.size();
+        }
+        ASSERT_EQUAL(paginated, seq_page.documents.size());
+    }
+
+    // Пока индекс не менялся, страницы внутри уже сделанного отбора не ранжируются заново
+    auto cursor = server.FindTopDocumentsPage(query, DocumentStatus::ACTUAL, 0, 10).next;
+    cursor = server.FindNextPage(cursor, 10).next;
+    cursor = server.FindNextPage(cursor, 10).next;
+    server.ResetPruningStats();
+    const auto cached_page = server.FindNextPage(cursor, 10);
+    ASSERT_EQUAL(server.GetPruningStats().scored_postings, 0u);
+    ASSERT(same_documents(cached_page.documents.begin(), cached_page.documents.end(),
+        expected.begin() + 30, expected.begin() + 40));
+
+    // После изменения индекса продолжение ранжирует запрос заново
+    server.AddDocument(1000, "fluffy fluffy cat"s, DocumentStatus::ACTUAL, { 100 });
+    const auto updated = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000);
+    const auto updated_page = server.FindNextPage(cursor, 10);
+    ASSERT(server.GetPruningStats().scored_postings > 0);
+    ASSERT(same_documents(updated_page.documents.begin(), updated_page.documents.end(),
+        updated.begin() + 30, updated.begin() + 40));
+
+    try {
+        server.FindTopDocumentsPage(query, DocumentStatus::ACTUAL, 0, 0);
+        ASSERT_HINT(false, "Empty page must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    try {
+        server.FindTopDocumentsPage(query, static_cast<DocumentStatus>(9), 0, 5);
+        ASSERT_HINT(false, "Invalid status must be rejected"s);
+    }
+    catch (const std::invalid_argument&) {
+    }
+}
+
 
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer() {
@@ -345,5 +1739,30 @@ void TestSearchServer() {
     RUN_TEST(TestRescueStatusDocumentContent);
     RUN_TEST(TestRelevanceDocumentContent);
     RUN_TEST(TestPredicateDocumentContent);
+    RUN_TEST(TestRemoveDocumentContent);
+    RUN_TEST(TestMatchingAfterRemoveDocument);
+    RUN_TEST(TestRepeatedQueriesAcrossServers);
+    RUN_TEST(TestTopDocumentsCount);
+    RUN_TEST(TestDocumentAtATimeEvaluation);
+    RUN_TEST(TestParallelPartitionedSearch);
+    RUN_TEST(TestConcurrentMap);
+    RUN_TEST(TestBatchQueries);
+    RUN_TEST(TestProcessQueriesJoined);
+    RUN_TEST(TestQueryCache);
+    RUN_TEST(TestMemoryUsage);
+    RUN_TEST(TestAddDocumentsBatch);
+    RUN_TEST(TestSnapshot);
+    RUN_TEST(TestPostingListCompression);
+    RUN_TEST(TestTokenizer);
+    RUN_TEST(TestQueryContextAllocations);
+    RUN_TEST(TestIncrementalInverseDocumentFreq);
+    RUN_TEST(TestRemoveDocumentsDeferred);
+    RUN_TEST(TestConcurrentSearchServer);
+    RUN_TEST(TestSegmentedIndex);
+    RUN_TEST(TestWordFrequenciesView);
+    RUN_TEST(TestMatchDocuments);
+    RUN_TEST(TestStatusPushdown);
+    RUN_TEST(TestDocumentMetadataColumns);
+    RUN_TEST(TestPagedSearch);
 
 }
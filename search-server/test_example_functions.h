@@ -80,6 +80,80 @@ void TestRescueStatusDocumentContent();
 // Корректное вычисление релевантности найденных документов
 void TestRelevanceDocumentContent();
 
+// Удалённый документ не находится поиском, а его идентификатор можно использовать повторно
+void TestRemoveDocumentContent();
+
+// Слова документа остаются доступными после удаления документа, в котором они встретились впервые
+void TestMatchingAfterRemoveDocument();
+
+// Повторные запросы к разным серверам в одном потоке не влияют друг на друга
+void TestRepeatedQueriesAcrossServers();
+// Количество возвращаемых документов задаётся при вызове, порядок выдачи сохраняется
+void TestTopDocumentsCount();
+
+// Обход документ за документом с отсечением возвращает те же документы, что и обход слово за словом
+void TestDocumentAtATimeEvaluation();
+
+// Параллельный поиск по диапазонам документов возвращает то же, что и последовательный
+void TestParallelPartitionedSearch();
+
+// Карта для параллельного накопления: прибавление, удаление, обход и извлечение значений
+void TestConcurrentMap();
+
+// Пакетный поиск возвращает для каждого запроса то же, что и одиночный
+void TestBatchQueries();
+
+// Объединённая выдача пакета запросов совпадает с выдачей по каждому запросу и сохраняет их порядок
+void TestProcessQueriesJoined();
+
+// Кеш результатов возвращает ту же выдачу и сбрасывается при изменении индекса
+void TestQueryCache();
+
+// Память индекса учитывается по составляющим, тексты и слова не дублируются
+void TestMemoryUsage();
+
+// Пакетное добавление документов строит тот же индекс, что и добавление по одному
+void TestAddDocumentsBatch();
+
+// Снимок индекса восстанавливает ту же выдачу, повреждённый файл отвергается
+void TestSnapshot();
+
+// Сжатый постинг-лист возвращает те же постинги при обходе, переходах курсора и удалениях
+void TestPostingListCompression();
+
+// Токенизатор: ядра совпадают с разбиением по find, управляющие символы отвергаются
+void TestTokenizer();
+
+// Поиск через контекст запроса совпадает с обычным и после прогрева не выделяет память
+void TestQueryContextAllocations();
+
+// IDF поддерживается при добавлении, удалении и загрузке снимка
+void TestIncrementalInverseDocumentFreq();
+
+// Отложенное удаление: документы сразу исчезают из выдачи, постинги освобождаются при сжатии
+void TestRemoveDocumentsDeferred();
+
+// Одновременные чтения и записи: читатели видят согласованные поколения, копии совпадают
+void TestConcurrentSearchServer();
+
+// Тест проверяет, что сегментированный индекс с фоновыми слияниями находит то же, что и несегментированный
+void TestSegmentedIndex();
+
+// Тест проверяет частоты слов документа из компактного прямого индекса
+void TestWordFrequenciesView();
+
+// Тест проверяет, что пакетное сопоставление запроса совпадает с MatchDocument для каждого документа
+void TestMatchDocuments();
+
+// Тест проверяет, что фильтр по статусу через маски даёт те же результаты, что и предикат
+void TestStatusPushdown();
+
+// Тест проверяет, что рейтинг и статус из столбцов метаданных совпадают с заданными при добавлении
+void TestDocumentMetadataColumns();
+
+// Тест проверяет постраничный поиск по смещению и по продолжению
+void TestPagedSearch();
+
 
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer();
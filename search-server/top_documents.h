@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+// Отбор K лучших документов без сортировки всех найденных: ограниченная куча,
+// в вершине которой находится худший из отобранных документов.
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t max_count)
+        : max_count_(max_count) {
+    }
+
+    static constexpr double RELEVANCE_EPSILON = 1e-6;
+
+    // Порядок выдачи: по убыванию релевантности, при равной (с точностью до 1e-6) — по убыванию рейтинга.
+    // Полностью равные документы упорядочиваются по id, чтобы выдача не зависела от порядка обхода.
+    static bool IsBetter(const Document& lhs, const Document& rhs) {
+        if (lhs.relevance > rhs.relevance) {
+            return true;
+        }
+        if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_EPSILON) {
+            return lhs.rating > rhs.rating || (lhs.rating == rhs.rating && lhs.relevance == rhs.relevance && lhs.id < rhs.id);
+        }
+        return false;
+    }
+
+    void Push(const Document& document) {
+        if (documents_.size() < max_count_) {
+            documents_.push_back(document);
+            std::push_heap(documents_.begin(), documents_.end(), IsBetter);
+        }
+        else if (max_count_ > 0 && IsBetter(document, documents_.front())) {
+            std::pop_heap(documents_.begin(), documents_.end(), IsBetter);
+            documents_.back() = document;
+            std::push_heap(documents_.begin(), documents_.end(), IsBetter);
+        }
+    }
+
+    size_t GetMaxCount() const {
+        return max_count_;
+    }
+
+    bool IsFull() const {
+        return !documents_.empty() && documents_.size() == max_count_;
+    }
+
+    const Document& GetWorst() const {
+        return documents_.front();
+    }
+
+    // Начинает новый отбор, сохраняя выделенную память
+    void Reset(size_t max_count) {
+        max_count_ = max_count;
+        documents_.clear();
+    }
+
+    // Упорядочивает отобранные документы на месте; до Reset добавлять документы больше нельзя
+    const std::vector<Document>& Sort() {
+        std::sort_heap(documents_.begin(), documents_.end(), IsBetter);
+        return documents_;
+    }
+
+    std::vector<Document> Extract() {
+        std::sort_heap(documents_.begin(), documents_.end(), IsBetter);
+        return std::move(documents_);
+    }
+
+private:
+    size_t max_count_;
+    std::vector<Document> documents_;
+};